@@ -0,0 +1,76 @@
+#include "barriertracker.h"
+
+// Every way a resource written by a shader is read again in the editor
+static const GLbitfield TextureBarriers = GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+static const GLbitfield BufferBarriers = GL_SHADER_STORAGE_BARRIER_BIT;
+
+BarrierTracker::BarrierTracker() :
+	m_Required(0),
+	m_NumBarriers(0)
+{
+}
+
+BarrierTracker::~BarrierTracker()
+{
+}
+
+void BarrierTracker::ResetStats()
+{
+	m_NumBarriers = 0;
+}
+
+int BarrierTracker::NumBarriers()
+{
+	return m_NumBarriers;
+}
+
+void BarrierTracker::ReadTexture(GLuint texture, GLbitfield barrier)
+{
+	Require(m_Textures, texture, barrier);
+}
+
+void BarrierTracker::ReadBuffer(GLuint buffer, GLbitfield barrier)
+{
+	Require(m_Buffers, buffer, barrier);
+}
+
+void BarrierTracker::Flush()
+{
+	if (!m_Required)
+		return;
+	glMemoryBarrier(m_Required);
+	m_NumBarriers++;
+	Issue(m_Textures, TextureBarriers);
+	Issue(m_Buffers, BufferBarriers);
+	m_Required = 0;
+}
+
+void BarrierTracker::WriteTexture(GLuint texture)
+{
+	m_Textures[texture] = 0;
+}
+
+void BarrierTracker::WriteBuffer(GLuint buffer)
+{
+	m_Buffers[buffer] = 0;
+}
+
+void BarrierTracker::Require(std::unordered_map<GLuint, GLbitfield>& resources, GLuint resource, GLbitfield barrier)
+{
+	auto iter = resources.find(resource);
+	if (iter != resources.end() && !(iter->second & barrier))
+		m_Required |= barrier;
+}
+
+void BarrierTracker::Issue(std::unordered_map<GLuint, GLbitfield>& resources, GLbitfield allBarriers)
+{
+	// A barrier orders every write before it, not only the ones that asked for it
+	for (auto iter = resources.begin(); iter != resources.end();)
+	{
+		iter->second |= m_Required;
+		if ((iter->second & allBarriers) == allBarriers)
+			iter = resources.erase(iter);
+		else
+			iter++;
+	}
+}
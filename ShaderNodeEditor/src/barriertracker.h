@@ -0,0 +1,38 @@
+#pragma once
+
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+// Tracks textures and buffers written through image stores and storage
+// buffers, and issues only the barrier bits their later readers need,
+// merged into a single glMemoryBarrier before the first dependent command
+class BarrierTracker
+{
+private:
+	// Barrier bits issued since each resource was last written
+	std::unordered_map<GLuint, GLbitfield> m_Textures;
+	std::unordered_map<GLuint, GLbitfield> m_Buffers;
+	GLbitfield m_Required;
+
+	int m_NumBarriers;
+
+public:
+	BarrierTracker();
+	~BarrierTracker();
+
+public:
+	void ResetStats();
+	int NumBarriers();
+
+public:
+	void ReadTexture(GLuint texture, GLbitfield barrier);
+	void ReadBuffer(GLuint buffer, GLbitfield barrier);
+	void Flush();
+	void WriteTexture(GLuint texture);
+	void WriteBuffer(GLuint buffer);
+
+private:
+	void Require(std::unordered_map<GLuint, GLbitfield>& resources, GLuint resource, GLbitfield barrier);
+	void Issue(std::unordered_map<GLuint, GLbitfield>& resources, GLbitfield allBarriers);
+};
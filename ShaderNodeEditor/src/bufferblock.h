@@ -7,8 +7,11 @@ class BufferBlock
 private:
 	std::string m_Name;
 	std::vector<ShaderVar> m_Vars;
+	int m_Index;
 	int m_Binding;
 	int m_Size;
+	std::vector<ProgramLocation> m_Locations;
+	int m_Stride;
 
 public:
 	BufferBlock();
@@ -17,11 +20,18 @@ public:
 
 public:
 	void SetName(const char* name);
-	std::string GetName();
-	std::vector<ShaderVar> GetVars();
+	const std::string& GetName() const;
+	const std::vector<ShaderVar>& GetVars() const;
+	void SetIndex(int index);
+	int GetIndex() const;
 	void SetBinding(int binding);
-	int GetBinding();
-	int size();
+	int GetBinding() const;
+	void AddLocation(const ProgramLocation& location);
+	const std::vector<ProgramLocation>& GetLocations() const;
+	void SetSize(int size);
+	int size() const;
+	void SetStride(int stride);
+	int GetStride() const;
 
 public:
 	void AddVar(ShaderVar& var);
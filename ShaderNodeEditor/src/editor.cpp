@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <sstream>
+#include <unordered_map>
 
 #include <fonts/sourcesanspro.h> // Text font: Source Sans Pro
 #include <fonts/forkawesome.h> // Icon font: Fork Awesome
@@ -10,6 +12,11 @@
 #include "tinyfiledialogs.h" // Cross-platform file dialogs library
 
 #include "pathutil.h"
+#include "shaders.h"
+#include "preprocessor.h"
+#include "stagecache.h"
+#include "imagecache.h"
+#include "textureformat.h"
 
 ShaderNodeEditor::ShaderNodeEditor() :
     m_NormalIconFont(0),
@@ -21,8 +28,14 @@ ShaderNodeEditor::ShaderNodeEditor() :
     m_StartedLinkPinId(-1),
     m_bLinkHanged(false),
     m_OnInit(true),
+    m_IsWaitingForPrograms(false),
     m_IsPlaying(false),
-    m_PingPongSwap(false)
+    m_PingPongSwap(false),
+    m_FramePlanDirty(true),
+    m_UniformRing(GL_UNIFORM_BUFFER),
+    m_NumUniformUploads(0),
+    m_NumBlockUploads(0),
+    m_EmptyVertexArray(-1)
 {
     m_StartTime = std::chrono::high_resolution_clock::now();
 }
@@ -53,6 +66,12 @@ ShaderNodeEditor::~ShaderNodeEditor()
         texture->Destroy();
         delete texture;
     }
+
+    m_UniformRing.Destroy();
+    m_TextureUploader.Destroy();
+    m_GpuTimer.Destroy();
+    if (m_EmptyVertexArray != -1)
+        glDeleteVertexArrays(1, &m_EmptyVertexArray);
 }
 
 void ShaderNodeEditor::ConfigImGui()
@@ -194,6 +213,7 @@ void ShaderNodeEditor::DeleteProgram(int ix)
 	m_Programs[ix]->Destroy();
     delete m_Programs[ix];
 	m_Programs.erase(m_Programs.begin() + ix);
+    UpdateWatchedFiles();
 }
 
 void ShaderNodeEditor::AddFramebuffer(Framebuffer* pFramebuffer)
@@ -258,6 +278,7 @@ void ShaderNodeEditor::DeleteTexture(int ix)
         UpdateLinks();
     }
 
+    ImageCache::Invalidate(m_Textures[ix]->GetPath());
     m_Textures[ix]->Destroy();
     delete m_Textures[ix];
     m_Textures.erase(m_Textures.begin() + ix);
@@ -321,6 +342,8 @@ void ShaderNodeEditor::DeletePin(EditorPin* pin)
     }
     m_Pins[pin->id] = 0;
     delete pin;
+
+    m_FramePlanDirty = true;
 }
 
 void ShaderNodeEditor::DeleteNodePinsAndLinks(int id)
@@ -345,6 +368,8 @@ void ShaderNodeEditor::DeleteNode(int id)
     DeleteNodePinsAndLinks(id);
     delete m_Nodes[id];
     m_Nodes[id] = 0;
+
+    m_FramePlanDirty = true;
 }
 
 void ShaderNodeEditor::DeleteLink(int id, bool checkPingPongNodes)
@@ -423,10 +448,32 @@ void ShaderNodeEditor::DeleteLink(int id, bool checkPingPongNodes)
 
     delete m_Links[id];
     m_Links[id] = 0;
+
+    m_FramePlanDirty = true;
 }
 
 void ShaderNodeEditor::CreateLink(int startPinId, int endPinId)
 {
+    // Specialization constants only take values typed on the node
+    if (m_Pins[startPinId]->isSpecConstant || m_Pins[endPinId]->isSpecConstant)
+        return;
+
+    // Samplers pass their input texture through, a loop of them would never reach a texture
+    EditorPin* outPin = m_Pins[startPinId]->isOutput ? m_Pins[startPinId] : m_Pins[endPinId];
+    EditorPin* inPin = outPin == m_Pins[startPinId] ? m_Pins[endPinId] : m_Pins[startPinId];
+    if (outPin->type == EditorPinType::TEXTURE && inPin->pNode->type == EditorNodeType::SAMPLER)
+    {
+        EditorNode* upstream = outPin->pNode;
+        for (int steps = 0; upstream && upstream->type == EditorNodeType::SAMPLER && steps < m_Nodes.size(); steps++)
+        {
+            if (upstream == inPin->pNode)
+                return;
+            EditorPin* samplerIn = upstream->pinsIn[0];
+            upstream = samplerIn->connectedLinks.size() > 0 ?
+                GetConnectedPin(upstream, samplerIn->connectedLinks[0])->pNode : 0;
+        }
+    }
+
     bool canCreateLink = false;
     if (m_Pins[startPinId]->type == m_Pins[endPinId]->type)
     {
@@ -593,10 +640,15 @@ void ShaderNodeEditor::CreateLink(int startPinId, int endPinId)
         m_Pins[startPinId]->connectedLinks.push_back(link);
         m_Pins[endPinId]->connectedLinks.push_back(link);
         m_Links.push_back(link);
+
+        if (inPin->pNode->type == EditorNodeType::SAMPLER)
+            UpdateSamplerNode((EditorSamplerNode*)inPin->pNode);
+
+        m_FramePlanDirty = true;
     }
 }
 
-EditorPin* ShaderNodeEditor::AllocPin(ShaderVar* var)
+EditorPin* ShaderNodeEditor::AllocPin(const ShaderVar* var)
 {
     auto type = EditorNodeUtil::GLTypeToPinType(var->GetType());
     EditorPin* pin;
@@ -621,56 +673,27 @@ EditorPin* ShaderNodeEditor::AllocPin(ShaderVar* var)
     return pin;
 }
 
-EditorProgramNode* ShaderNodeEditor::CreateProgramNodePtr(int progId, const ImVec2& pos)
+void ShaderNodeEditor::AllocProgramPins(EditorProgramNode* node,
+    std::vector<EditorPin*>& pinsIn, std::vector<EditorPin*>& pinsOut)
 {
-    Program* pProgram = m_Programs[progId];
-
-    EditorProgramNode* node = new EditorProgramNode;
-    node->type = EditorNodeType::PROGRAM;
-    node->nodePos = pos;
-    node->target = pProgram;
-    node->framebuffer = m_Framebuffers[0];
-
-    // Flow in & out
-    {
-        EditorPin* pinIn = new EditorPin;
-        pinIn->id = m_Pins.size();
-        pinIn->pNode = node;
-        pinIn->type = EditorPinType::FLOW;
-        node->pinsIn.push_back(pinIn);
-        node->flowIn = pinIn;
-        m_Pins.push_back(pinIn);
-        EditorPin* pinOut = new EditorPin;
-        pinOut->id = m_Pins.size();
-        pinOut->pNode = node;
-        pinOut->type = EditorPinType::FLOW;
-        pinOut->isOutput = true;
-        node->pinsOut.push_back(pinOut);
-        node->flowOut = pinOut;
-        m_Pins.push_back(pinOut);
-    }
+    Program* pProgram = node->target;
 
     // Uniforms
     for (auto& uniform : pProgram->GetUniforms())
     {
         EditorPin* pin = AllocPin(&uniform.var);
-        pin->id = m_Pins.size();
         pin->pNode = node;
         pin->name = uniform.var.GetName();
         pin->type = EditorNodeUtil::GLTypeToPinType(uniform.var.GetType());
-        node->pinsIn.push_back(pin);
-        m_Pins.push_back(pin);
+        pinsIn.push_back(pin);
         if (pin->type == EditorPinType::IMAGE)
         {
             EditorPin* pinOut = new EditorPin;
-            pinOut->id = m_Pins.size();
             pinOut->pNode = node;
             pinOut->name = uniform.var.GetName();
             pinOut->type = EditorPinType::IMAGE;
             pinOut->isOutput = true;
-            node->pinsOut.push_back(pinOut);
-            node->attachmentsPinsStartId++;
-            m_Pins.push_back(pinOut);
+            pinsOut.push_back(pinOut);
         }
     }
     // Uniform blocks
@@ -678,33 +701,28 @@ EditorProgramNode* ShaderNodeEditor::CreateProgramNodePtr(int progId, const ImVe
     for (auto& uniformBlock : pProgram->GetUniformBlocks())
     {
         EditorBlockPin* pin = new EditorBlockPin;
-        pin->id = m_Pins.size();
         pin->pNode = node;
         pin->name = uniformBlock.GetName();
         pin->type = EditorPinType::BLOCK;
         pin->blockPinType = EditorBlockPinType::UNIFROM_BLOCK;
         pin->index = index++;
         pin->size = uniformBlock.size();
-        node->pinsIn.push_back(pin);
-        m_Pins.push_back(pin);
+        pinsIn.push_back(pin);
     }
     // Buffer blocks
     index = 0;
     for (auto& bufferBlock : pProgram->GetBufferBlocks())
     {
         EditorBlockPin* pin = new EditorBlockPin;
-        pin->id = m_Pins.size();
         pin->pNode = node;
         pin->name = bufferBlock.GetName();
         pin->type = EditorPinType::BLOCK;
         pin->blockPinType = EditorBlockPinType::BUFFER_BLOCK;
         pin->index = index;
         pin->size = bufferBlock.size();
-        node->pinsIn.push_back(pin);
-        m_Pins.push_back(pin);
+        pinsIn.push_back(pin);
 
         EditorBlockPin* pinOut = new EditorBlockPin;
-        pinOut->id = m_Pins.size();
         pinOut->pNode = node;
         pinOut->name = bufferBlock.GetName();
         pinOut->type = EditorPinType::BLOCK;
@@ -712,11 +730,80 @@ EditorProgramNode* ShaderNodeEditor::CreateProgramNodePtr(int progId, const ImVe
         pinOut->index = index++;
         pinOut->size = bufferBlock.size();
         pinOut->isOutput = true;
+        pinsOut.push_back(pinOut);
+    }
+    // Specialization constants, set from the node and not linkable
+    for (auto& constant : pProgram->GetSpecConstants())
+    {
+        EditorPin* pin = 0;
+        if (constant.type == GL_FLOAT)
+        {
+            EditorFloatPin* floatPin = new EditorFloatPin;
+            floatPin->type = EditorPinType::FLOAT;
+            memcpy(&floatPin->value, &constant.value, sizeof(float));
+            pin = floatPin;
+        }
+        else
+        {
+            EditorIntPin* intPin = new EditorIntPin;
+            intPin->type = EditorPinType::INT;
+            intPin->value = (int)constant.value;
+            pin = intPin;
+        }
+        pin->pNode = node;
+        pin->name = constant.name;
+        pin->isSpecConstant = true;
+        pinsIn.push_back(pin);
+    }
+}
+
+EditorProgramNode* ShaderNodeEditor::CreateProgramNodePtr(int progId, const ImVec2& pos)
+{
+    Program* pProgram = m_Programs[progId];
+
+    EditorProgramNode* node = new EditorProgramNode;
+    node->type = EditorNodeType::PROGRAM;
+    node->nodePos = pos;
+    node->target = pProgram;
+    node->framebuffer = m_Framebuffers[0];
+
+    // Flow in & out
+    {
+        EditorPin* pinIn = new EditorPin;
+        pinIn->id = m_Pins.size();
+        pinIn->pNode = node;
+        pinIn->type = EditorPinType::FLOW;
+        node->pinsIn.push_back(pinIn);
+        node->flowIn = pinIn;
+        m_Pins.push_back(pinIn);
+        EditorPin* pinOut = new EditorPin;
+        pinOut->id = m_Pins.size();
+        pinOut->pNode = node;
+        pinOut->type = EditorPinType::FLOW;
+        pinOut->isOutput = true;
         node->pinsOut.push_back(pinOut);
-        node->attachmentsPinsStartId++;
+        node->flowOut = pinOut;
         m_Pins.push_back(pinOut);
     }
 
+    // Uniforms, blocks and their outputs
+    std::vector<EditorPin*> pinsIn;
+    std::vector<EditorPin*> pinsOut;
+    AllocProgramPins(node, pinsIn, pinsOut);
+    for (auto& pin : pinsIn)
+    {
+        pin->id = m_Pins.size();
+        node->pinsIn.push_back(pin);
+        m_Pins.push_back(pin);
+    }
+    for (auto& pin : pinsOut)
+    {
+        pin->id = m_Pins.size();
+        node->pinsOut.push_back(pin);
+        m_Pins.push_back(pin);
+    }
+    node->attachmentsPinsStartId = node->pinsOut.size();
+
     return node;
 }
 
@@ -735,128 +822,78 @@ void ShaderNodeEditor::CreateProgramNode(int progId, const ImVec2& pos)
     ImNodes::SelectNode(node->id);
 }
 
-void ShaderNodeEditor::UpdateProgramNode(int nodeId, int progId)
+bool ShaderNodeEditor::UpdateProgramNode(int nodeId, int progId)
 {
-    // Create new node
-    ImVec2 pos = m_Nodes[nodeId]->nodePos;
-    auto node = CreateProgramNodePtr(progId, pos);
-    node->id = nodeId;
+    // The reflected interface is diffed against the current pins by name and type.
+    // Unchanged pins keep their id, value and links, only added and removed pins are touched
+    EditorProgramNode* node = (EditorProgramNode*)m_Nodes[nodeId];
+    node->target = m_Programs[progId];
 
-    // Restore attributes
-    EditorProgramNode* nodeOld = (EditorProgramNode*)m_Nodes[nodeId];
-    auto iter = std::find(m_Framebuffers.begin(), m_Framebuffers.end(), nodeOld->framebuffer);
-    if (iter != m_Framebuffers.end())
-    {
-        int index = iter - m_Framebuffers.begin();
-        SetProgramNodeFramebuffer(node, index);
-    }
-    node->dispatchType = nodeOld->dispatchType;
-    node->drawMode = nodeOld->drawMode;
-    node->dispatchSize[0] = nodeOld->dispatchSize[0];
-    node->dispatchSize[1] = nodeOld->dispatchSize[1];
-    node->dispatchSize[2] = nodeOld->dispatchSize[2];
+    std::vector<EditorPin*> pinsIn;
+    std::vector<EditorPin*> pinsOut;
+    AllocProgramPins(node, pinsIn, pinsOut);
 
-    // Restore pins and links
-    for (int i = 0; i < node->pinsIn.size(); i++)
+    // Current interface pins, the flow pins and attachments don't depend on the program
+    std::vector<EditorPin*> oldPins(node->pinsIn.begin() + 1, node->pinsIn.end());
+    oldPins.insert(oldPins.end(), node->pinsOut.begin() + 1, node->pinsOut.begin() + node->attachmentsPinsStartId);
+    std::vector<EditorPin*> attachments(node->pinsOut.begin() + node->attachmentsPinsStartId, node->pinsOut.end());
+
+    auto reusePins = [&](std::vector<EditorPin*>& pins)
     {
-        if (i < nodeOld->pinsIn.size() &&
-            nodeOld->pinsIn[i]->type == node->pinsIn[i]->type &&
-            nodeOld->pinsIn[i]->size == node->pinsIn[i]->size)
+        for (auto& pin : pins)
         {
-            if (node->pinsIn[i]->type == EditorPinType::FLOAT)
-            {
-                auto newPin = (EditorFloatPin*)node->pinsIn[i];
-                auto oldPin = (EditorFloatPin*)nodeOld->pinsIn[i];
-                newPin->value = oldPin->value;
-            }
-            else if (node->pinsIn[i]->type == EditorPinType::FLOAT2)
-            {
-                auto newPin = (EditorFloat2Pin*)node->pinsIn[i];
-                auto oldPin = (EditorFloat2Pin*)nodeOld->pinsIn[i];
-                newPin->value[0] = oldPin->value[0];
-                newPin->value[1] = oldPin->value[1];
-            }
-            else if (node->pinsIn[i]->type == EditorPinType::FLOAT3)
-            {
-                auto newPin = (EditorFloat3Pin*)node->pinsIn[i];
-                auto oldPin = (EditorFloat3Pin*)nodeOld->pinsIn[i];
-                newPin->value[0] = oldPin->value[0];
-                newPin->value[1] = oldPin->value[1];
-                newPin->value[2] = oldPin->value[2];
-            }
-            else if (node->pinsIn[i]->type == EditorPinType::FLOAT4)
-            {
-                auto newPin = (EditorFloat4Pin*)node->pinsIn[i];
-                auto oldPin = (EditorFloat4Pin*)nodeOld->pinsIn[i];
-                newPin->value[0] = oldPin->value[0];
-                newPin->value[1] = oldPin->value[1];
-                newPin->value[2] = oldPin->value[2];
-                newPin->value[3] = oldPin->value[3];
-            }
-            else if (node->pinsIn[i]->type == EditorPinType::INT)
-            {
-                auto newPin = (EditorIntPin*)node->pinsIn[i];
-                auto oldPin = (EditorIntPin*)nodeOld->pinsIn[i];
-                newPin->value = oldPin->value;
-            }
-            else if (node->pinsIn[i]->type == EditorPinType::INT2)
+            auto found = std::find_if(oldPins.begin(), oldPins.end(), [&](EditorPin* oldPin)
             {
-                auto newPin = (EditorInt2Pin*)node->pinsIn[i];
-                auto oldPin = (EditorInt2Pin*)nodeOld->pinsIn[i];
-                newPin->value[0] = oldPin->value[0];
-                newPin->value[1] = oldPin->value[1];
-            }
-            else if (node->pinsIn[i]->type == EditorPinType::INT3)
-            {
-                auto newPin = (EditorInt3Pin*)node->pinsIn[i];
-                auto oldPin = (EditorInt3Pin*)nodeOld->pinsIn[i];
-                newPin->value[0] = oldPin->value[0];
-                newPin->value[1] = oldPin->value[1];
-                newPin->value[2] = oldPin->value[2];
-            }
-            else if (node->pinsIn[i]->type == EditorPinType::INT4)
+                if (!oldPin || oldPin->name != pin->name || oldPin->type != pin->type ||
+                    oldPin->isOutput != pin->isOutput || oldPin->size != pin->size ||
+                    oldPin->isSpecConstant != pin->isSpecConstant)
+                    return false;
+                return pin->type != EditorPinType::BLOCK ||
+                    ((EditorBlockPin*)oldPin)->blockPinType == ((EditorBlockPin*)pin)->blockPinType;
+            });
+            if (found == oldPins.end())
             {
-                auto newPin = (EditorInt4Pin*)node->pinsIn[i];
-                auto oldPin = (EditorInt4Pin*)nodeOld->pinsIn[i];
-                newPin->value[0] = oldPin->value[0];
-                newPin->value[1] = oldPin->value[1];
-                newPin->value[2] = oldPin->value[2];
-                newPin->value[3] = oldPin->value[3];
+                pin->id = m_Pins.size();
+                m_Pins.push_back(pin);
+                continue;
             }
 
-            for (auto& link : nodeOld->pinsIn[i]->connectedLinks)
-            {
-                if (link->pPin1 == nodeOld->pinsIn[i])
-                    link->pPin1 = node->pinsIn[i];
-                if (link->pPin2 == nodeOld->pinsIn[i])
-                    link->pPin2 = node->pinsIn[i];
-                node->pinsIn[i]->connectedLinks.push_back(link);
-            }
-            std::vector<EditorLink*>().swap(nodeOld->pinsIn[i]->connectedLinks);
+            // Block indices may move between links
+            EditorPin* oldPin = *found;
+            oldPin->dirty = true;
+            if (pin->type == EditorPinType::BLOCK)
+                ((EditorBlockPin*)oldPin)->index = ((EditorBlockPin*)pin)->index;
+            // Specialization constants are owned by the program, which other nodes may have changed
+            if (pin->isSpecConstant && pin->type == EditorPinType::FLOAT)
+                ((EditorFloatPin*)oldPin)->value = ((EditorFloatPin*)pin)->value;
+            else if (pin->isSpecConstant)
+                ((EditorIntPin*)oldPin)->value = ((EditorIntPin*)pin)->value;
+            delete pin;
+            pin = oldPin;
+            *found = 0;
         }
-    }
-    for (int i = 0; i < node->pinsOut.size(); i++)
+    };
+    reusePins(pinsIn);
+    reusePins(pinsOut);
+
+    pinsIn.insert(pinsIn.begin(), node->flowIn);
+    pinsOut.insert(pinsOut.begin(), node->flowOut);
+    node->attachmentsPinsStartId = pinsOut.size();
+    pinsOut.insert(pinsOut.end(), attachments.begin(), attachments.end());
+    node->pinsIn = pinsIn;
+    node->pinsOut = pinsOut;
+
+    // Pins that are gone leave holes, which only then need compacting
+    bool isRemoved = false;
+    for (auto& oldPin : oldPins)
     {
-        if (i < nodeOld->pinsOut.size() &&
-            nodeOld->pinsOut[i]->type == node->pinsOut[i]->type &&
-            nodeOld->pinsOut[i]->size == node->pinsOut[i]->size)
-        {
-            for (auto& link : nodeOld->pinsOut[i]->connectedLinks)
-            {
-                if (link->pPin1 == nodeOld->pinsOut[i])
-                    link->pPin1 = node->pinsOut[i];
-                if (link->pPin2 == nodeOld->pinsOut[i])
-                    link->pPin2 = node->pinsOut[i];
-                node->pinsOut[i]->connectedLinks.push_back(link);
-            }
-            std::vector<EditorLink*>().swap(nodeOld->pinsOut[i]->connectedLinks);
-        }
+        if (!oldPin)
+            continue;
+        DeletePin(oldPin);
+        isRemoved = true;
     }
-
-    // Replace the old with the new one
-    DeleteNodePinsAndLinks(nodeId);
-    delete m_Nodes[nodeId];
-    m_Nodes[nodeId] = node;
+    m_FramePlanDirty = true;
+    return isRemoved;
 }
 
 void ShaderNodeEditor::SetProgramNodeFramebuffer(EditorProgramNode* node, int framebufferId)
@@ -894,6 +931,8 @@ void ShaderNodeEditor::SetProgramNodeFramebuffer(EditorProgramNode* node, int fr
         m_Pins.push_back(pin);
     }
     node->framebuffer = framebuffer;
+
+    m_FramePlanDirty = true;
 }
 
 void ShaderNodeEditor::CreateBlockNode(const ImVec2& pos, int pinId)
@@ -909,7 +948,7 @@ void ShaderNodeEditor::CreateBlockNode(const ImVec2& pos, int pinId)
         EditorProgramNode* progNode = (EditorProgramNode*)progPin->pNode;
         if (progPin->blockPinType == EditorBlockPinType::UNIFROM_BLOCK)
         {
-            UniformBlock block = progNode->target->GetUniformBlocks()[progPin->index];
+            const UniformBlock& block = progNode->target->GetUniformBlock(progPin->index);
             for (auto& uniform : block.GetUniforms())
             {
                 EditorPin* pin = AllocPin(&uniform.var);
@@ -917,14 +956,15 @@ void ShaderNodeEditor::CreateBlockNode(const ImVec2& pos, int pinId)
                 pin->pNode = blockNode;
                 pin->name = uniform.var.GetName();
                 pin->type = EditorNodeUtil::GLTypeToPinType(uniform.var.GetType());
+                pin->offset = uniform.var.GetOffset();
                 blockNode->pinsIn.push_back(pin);
                 m_Pins.push_back(pin);
-                size += EditorNodeUtil::PinTypeSize(pin->type);
             }
+            size = block.size();
         }
         else
         {
-            BufferBlock block = progNode->target->GetBufferBlocks()[progPin->index];
+            const BufferBlock& block = progNode->target->GetBufferBlock(progPin->index);
             for (auto& var : block.GetVars())
             {
                 EditorPin* pin = AllocPin(&var);
@@ -932,10 +972,13 @@ void ShaderNodeEditor::CreateBlockNode(const ImVec2& pos, int pinId)
                 pin->pNode = blockNode;
                 pin->name = var.GetName();
                 pin->type = EditorNodeUtil::GLTypeToPinType(var.GetType());
+                pin->offset = var.GetOffset();
                 blockNode->pinsIn.push_back(pin);
                 m_Pins.push_back(pin);
-                size += EditorNodeUtil::PinTypeSize(pin->type);
             }
+            size = block.size();
+            blockNode->stride = block.GetStride();
+            blockNode->isStd430 = true;
         }
     }
 
@@ -960,15 +1003,9 @@ void ShaderNodeEditor::CreateBlockNode(const ImVec2& pos, int pinId)
 
     blockNode->id = m_Nodes.size();
     blockNode->size = size;
+    blockNode->data.assign(size, 0);
 
-    glGenBuffers(1, &blockNode->ubo);
-    glBindBuffer(GL_UNIFORM_BUFFER, blockNode->ubo);
-    glBufferData(GL_UNIFORM_BUFFER, blockNode->size, NULL, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
-    glGenBuffers(1, &blockNode->ssbo);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, blockNode->ssbo);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, blockNode->size * blockNode->ssboSize, NULL, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    AllocBlockBuffers(blockNode);
 
     m_Nodes.push_back(blockNode);
 
@@ -981,6 +1018,45 @@ void ShaderNodeEditor::CreateBlockNode(const ImVec2& pos, int pinId)
     ImNodes::SelectNode(blockNode->id);
 }
 
+void ShaderNodeEditor::LayoutBlockNode(EditorBlockNode* node)
+{
+    // Hand-edited blocks have no reflected layout, lay them out by the block's
+    // std140 or std430 rules. Members are scalars and vectors, so the two only
+    // differ in std140 rounding the block size up to a vec4
+    int offset = 0;
+    int blockAlignment = 4;
+    for (auto& pin : node->pinsIn)
+    {
+        int alignment = EditorNodeUtil::PinTypeAlignment(pin->type);
+        offset = (offset + alignment - 1) / alignment * alignment;
+        pin->offset = offset;
+        offset += EditorNodeUtil::PinTypeSize(pin->type);
+        blockAlignment = std::max(blockAlignment, alignment);
+    }
+    if (!node->isStd430)
+        blockAlignment = 16;
+    node->size = (offset + blockAlignment - 1) / blockAlignment * blockAlignment;
+    node->stride = 0;
+    node->data.assign(node->size, 0);
+    node->dirty = true;
+    node->pinsOut[0]->size = node->size;
+}
+
+void ShaderNodeEditor::AllocBlockBuffers(EditorBlockNode* node)
+{
+    // Storage is immutable, so resizing recreates the buffers. The resident
+    // copy is rewritten with glNamedBufferSubData, which needs dynamic storage.
+    // Immutable storage can't be empty, a block without members gets one word
+    if (node->ubo != -1)
+        glDeleteBuffers(1, &node->ubo);
+    if (node->ssbo != -1)
+        glDeleteBuffers(1, &node->ssbo);
+    glCreateBuffers(1, &node->ubo);
+    glNamedBufferStorage(node->ubo, std::max(node->size, 4), NULL, GL_DYNAMIC_STORAGE_BIT);
+    glCreateBuffers(1, &node->ssbo);
+    glNamedBufferStorage(node->ssbo, std::max(EditorNodeUtil::BlockStorageSize(node), 4), NULL, GL_DYNAMIC_STORAGE_BIT);
+}
+
 void ShaderNodeEditor::CreateTextureNode(int textureId, const ImVec2& pos)
 {
     EditorTextureNode* node = new EditorTextureNode;
@@ -1041,10 +1117,7 @@ void ShaderNodeEditor::CreateImageNode(const ImVec2& pos)
     node->pinsOut.push_back(pinOut2);
     m_Pins.push_back(pinOut2);
 
-    glGenTextures(1, &node->texture);
-    glBindTexture(GL_TEXTURE_2D, node->texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    AllocImageNodeTexture(node);
 
     node->id = m_Nodes.size();
     m_Nodes.push_back(node);
@@ -1058,6 +1131,88 @@ void ShaderNodeEditor::CreateImageNode(const ImVec2& pos)
     ImNodes::SelectNode(node->id);
 }
 
+void ShaderNodeEditor::AllocImageNodeTexture(EditorImageNode* node)
+{
+    // Storage is immutable, so resizing recreates the texture
+    if (node->texture != -1)
+        glDeleteTextures(1, &node->texture);
+    glCreateTextures(GL_TEXTURE_2D, 1, &node->texture);
+    if (node->sizeX > 0 && node->sizeY > 0)
+        glTextureStorage2D(node->texture, 1, node->format, node->sizeX, node->sizeY);
+    // Integer formats are incomplete with linear filtering
+    GLenum filter = TextureFormat::FilterFor(node->format);
+    glTextureParameteri(node->texture, GL_TEXTURE_MIN_FILTER, filter);
+    glTextureParameteri(node->texture, GL_TEXTURE_MAG_FILTER, filter);
+}
+
+void ShaderNodeEditor::CreateSamplerNode(const ImVec2& pos)
+{
+    EditorSamplerNode* node = new EditorSamplerNode;
+    node->type = EditorNodeType::SAMPLER;
+    node->nodePos = pos;
+
+    EditorPin* pinIn = new EditorPin;
+    pinIn->name = "Texture";
+    pinIn->pNode = node;
+    pinIn->type = EditorPinType::TEXTURE;
+    pinIn->id = m_Pins.size();
+    node->pinsIn.push_back(pinIn);
+    m_Pins.push_back(pinIn);
+
+    EditorPin* pinOut = new EditorPin;
+    pinOut->name = "";
+    pinOut->pNode = node;
+    pinOut->type = EditorPinType::TEXTURE;
+    pinOut->isOutput = true;
+    pinOut->id = m_Pins.size();
+    node->pinsOut.push_back(pinOut);
+    m_Pins.push_back(pinOut);
+
+    UpdateSamplerNode(node);
+
+    node->id = m_Nodes.size();
+    m_Nodes.push_back(node);
+
+    ImNodes::SetNodeScreenSpacePos(node->id, pos);
+
+    m_SelectedItemType = SelectedItemType::SAMPLER_NODE;
+    m_SelectedItemId = node->id;
+    ImNodes::ClearLinkSelection();
+    ImNodes::ClearNodeSelection();
+    ImNodes::SelectNode(node->id);
+}
+
+void ShaderNodeEditor::UpdateSamplerNode(EditorSamplerNode* node)
+{
+    // Integer textures can only be sampled with nearest filtering, and mipmap
+    // filters would leave a single level texture incomplete
+    EditorPin* samplerIn = node->pinsIn[0];
+    EditorPin* source = samplerIn->connectedLinks.size() > 0 ? GetConnectedPin(node, samplerIn->connectedLinks[0]) : 0;
+    if (source && TextureFormat::IsInteger(GetTextureFormat(source)))
+    {
+        node->minFilter = GL_NEAREST;
+        node->magFilter = GL_NEAREST;
+        node->anisotropy = 1.0f;
+    }
+    else if (source && !HasMipmaps(source))
+    {
+        if (node->minFilter == GL_NEAREST_MIPMAP_NEAREST || node->minFilter == GL_NEAREST_MIPMAP_LINEAR)
+            node->minFilter = GL_NEAREST;
+        else if (node->minFilter == GL_LINEAR_MIPMAP_NEAREST || node->minFilter == GL_LINEAR_MIPMAP_LINEAR)
+            node->minFilter = GL_LINEAR;
+    }
+
+    // The sampler object is kept, so frame plans stay valid when only its parameters change
+    if (node->sampler == -1)
+        glCreateSamplers(1, &node->sampler);
+    glSamplerParameteri(node->sampler, GL_TEXTURE_MIN_FILTER, node->minFilter);
+    glSamplerParameteri(node->sampler, GL_TEXTURE_MAG_FILTER, node->magFilter);
+    glSamplerParameteri(node->sampler, GL_TEXTURE_WRAP_S, node->wrapS);
+    glSamplerParameteri(node->sampler, GL_TEXTURE_WRAP_T, node->wrapT);
+    if (GLEW_ARB_texture_filter_anisotropic || GLEW_EXT_texture_filter_anisotropic)
+        glSamplerParameterf(node->sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, node->anisotropy);
+}
+
 void ShaderNodeEditor::CreatePingPongNode(const ImVec2& pos, EditorPingPongNodeType type)
 {
     EditorPingPongNode* node = new EditorPingPongNode;
@@ -1356,7 +1511,8 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
         {
             ImGui::SameLine();
             ImGui::SetNextItemWidth(50.0f);
-            ImGui::InputFloat("", &p->value);
+            if (ImGui::InputFloat("", &p->value))
+                MarkPinDirty(pin);
         }
     }
     if (pin->type == EditorPinType::INT)
@@ -1366,7 +1522,8 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
         {
             ImGui::SameLine();
             ImGui::SetNextItemWidth(50.0f);
-            ImGui::InputInt("", &p->value, 0);
+            if (ImGui::InputInt("", &p->value, 0))
+                MarkPinDirty(pin);
         }
     }
     else if (pin->type == EditorPinType::FLOAT2)
@@ -1377,7 +1534,8 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
             ImGui::Dummy(ImVec2(11.0f, 1.0f));
             ImGui::SameLine();
             ImGui::SetNextItemWidth(100.0f);
-            ImGui::InputFloat2("", p->value);
+            if (ImGui::InputFloat2("", p->value))
+                MarkPinDirty(pin);
         }
     }
     else if (pin->type == EditorPinType::INT2)
@@ -1388,7 +1546,8 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
             ImGui::Dummy(ImVec2(11.0f, 1.0f));
             ImGui::SameLine();
             ImGui::SetNextItemWidth(100.0f);
-            ImGui::InputInt2("", p->value);
+            if (ImGui::InputInt2("", p->value))
+                MarkPinDirty(pin);
         }
     }
     else if (pin->type == EditorPinType::FLOAT3)
@@ -1399,7 +1558,8 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
             ImGui::Dummy(ImVec2(11.0f, 1.0f));
             ImGui::SameLine();
             ImGui::SetNextItemWidth(150.0f);
-            ImGui::InputFloat3("", p->value);
+            if (ImGui::InputFloat3("", p->value))
+                MarkPinDirty(pin);
         }
     }
     else if (pin->type == EditorPinType::INT3)
@@ -1410,7 +1570,8 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
             ImGui::Dummy(ImVec2(11.0f, 1.0f));
             ImGui::SameLine();
             ImGui::SetNextItemWidth(150.0f);
-            ImGui::InputInt3("", p->value);
+            if (ImGui::InputInt3("", p->value))
+                MarkPinDirty(pin);
         }
     }
     else if (pin->type == EditorPinType::FLOAT4)
@@ -1421,7 +1582,8 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
             ImGui::Dummy(ImVec2(11.0f, 1.0f));
             ImGui::SameLine();
             ImGui::SetNextItemWidth(200.0f);
-            ImGui::InputFloat4("", p->value);
+            if (ImGui::InputFloat4("", p->value))
+                MarkPinDirty(pin);
         }
     }
     else if (pin->type == EditorPinType::INT4)
@@ -1432,7 +1594,8 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
             ImGui::Dummy(ImVec2(11.0f, 1.0f));
             ImGui::SameLine();
             ImGui::SetNextItemWidth(200.0f);
-            ImGui::InputInt4("", p->value);
+            if (ImGui::InputInt4("", p->value))
+                MarkPinDirty(pin);
         }
     }
     ImNodes::EndInputAttribute();
@@ -1442,6 +1605,24 @@ void ShaderNodeEditor::InputPin(EditorNode* node, EditorPin* pin)
     ImGui::PopStyleColor();
 }
 
+void ShaderNodeEditor::MarkPinDirty(EditorPin* pin)
+{
+    pin->dirty = true;
+    if (pin->pNode->type == EditorNodeType::BLOCK)
+        ((EditorBlockNode*)pin->pNode)->dirty = true;
+
+    // The program is specialized again, the node picks up the new pins once it relinks
+    if (pin->isSpecConstant)
+    {
+        GLuint value = 0;
+        if (pin->type == EditorPinType::FLOAT)
+            memcpy(&value, &((EditorFloatPin*)pin)->value, sizeof(GLuint));
+        else
+            value = (GLuint)((EditorIntPin*)pin)->value;
+        ((EditorProgramNode*)pin->pNode)->target->SetSpecConstant(pin->name, value);
+    }
+}
+
 void ShaderNodeEditor::OutputPin(EditorNode* node, EditorPin* pin)
 {
     float alpha = 0.2f;
@@ -1483,7 +1664,7 @@ EditorPin* ShaderNodeEditor::GetConnectedPin(EditorNode* node, EditorLink* link)
     return (link->pPin1->pNode == node) ? link->pPin2 : link->pPin1;
 }
 
-void ShaderNodeEditor::GetInputTargetNode(EditorNode*& connectedNode, EditorPinType type, int index)
+void ShaderNodeEditor::GetInputTargetNode(EditorNode*& connectedNode, EditorPinType type, int index, bool swap)
 {
     EditorNodeType targetNodeType =
         type == EditorPinType::IMAGE ? EditorNodeType::IMAGE : EditorNodeType::BLOCK;
@@ -1492,7 +1673,7 @@ void ShaderNodeEditor::GetInputTargetNode(EditorNode*& connectedNode, EditorPinT
         if (connectedNode->type == EditorNodeType::PINGPONG)
         {
             auto pingpongNode = (EditorPingPongNode*)connectedNode;
-            if (m_PingPongSwap)
+            if (swap)
             {
                 if (pingpongNode->pinsIn[1]->connectedLinks.size() > 0)
                 {
@@ -1595,114 +1776,123 @@ void ShaderNodeEditor::GetInputTargetNode(EditorNode*& connectedNode, EditorPinT
     }
 }
 
-void ShaderNodeEditor::ExecuteProgramNode(EditorProgramNode* progNode)
+GLuint ShaderNodeEditor::GetImageNodeTexture(EditorImageNode* imgNode)
 {
-    // Setup program
-    glUseProgram(progNode->target->GetProgram());
-    if (progNode->dispatchType == EditorProgramDispatchType::ARRAY)
+    if (imgNode->pinsIn[0]->connectedLinks.size() > 0)
     {
-        auto framebuffer = progNode->framebuffer->GetFramebuffer();
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        if (framebuffer == 0)
-            glViewport(0, 0, m_RenderWidth, m_RenderHeight);
-        else
+        EditorNode* connectedNode = GetConnectedPin(imgNode, imgNode->pinsIn[0]->connectedLinks[0])->pNode;
+        if (connectedNode->type == EditorNodeType::TEXTURE)
+            return ((EditorTextureNode*)connectedNode)->target->GetTexture();
+    }
+    return imgNode->texture;
+}
+
+EditorPin* ShaderNodeEditor::GetTextureSource(EditorPin* pin)
+{
+    // Samplers pass their input through, the walk is bounded in case of loops
+    for (int steps = 0; pin && pin->pNode->type == EditorNodeType::SAMPLER && steps < m_Nodes.size(); steps++)
+    {
+        EditorPin* samplerIn = pin->pNode->pinsIn[0];
+        pin = samplerIn->connectedLinks.size() > 0 ? GetConnectedPin(pin->pNode, samplerIn->connectedLinks[0]) : 0;
+    }
+    return pin && pin->pNode->type == EditorNodeType::SAMPLER ? 0 : pin;
+}
+
+GLenum ShaderNodeEditor::GetTextureFormat(EditorPin* pin)
+{
+    pin = GetTextureSource(pin);
+    if (!pin)
+        return GL_RGBA8;
+
+    if (pin->pNode->type == EditorNodeType::PROGRAM)
+    {
+        auto progNode = (EditorProgramNode*)pin->pNode;
+        for (int i = progNode->attachmentsPinsStartId; i < progNode->pinsOut.size(); i++)
         {
-            int width, height;
-            progNode->framebuffer->GetSize(&width, &height);
-            glViewport(0, 0, width, height);
+            if (progNode->pinsOut[i] == pin)
+                return progNode->framebuffer->GetAttachmentFormat(i - progNode->attachmentsPinsStartId);
+        }
+    }
+    else if (pin->pNode->type == EditorNodeType::IMAGE)
+    {
+        // An image node fed by a texture passes the texture on instead of its own
+        auto imgNode = (EditorImageNode*)pin->pNode;
+        if (imgNode->pinsIn[0]->connectedLinks.size() == 0)
+            return imgNode->format;
+    }
+    // Textures loaded from files are never integer
+    return GL_RGBA8;
+}
 
-            int numAttachments = progNode->framebuffer->NumAttachments();
-            GLenum* attachments = new GLenum[numAttachments];
-            for (int i = 0; i < numAttachments; i++)
-                attachments[i] = GL_COLOR_ATTACHMENT0 + i;
-            glDrawBuffers(numAttachments, attachments);
-            delete[] attachments;
+bool ShaderNodeEditor::HasMipmaps(EditorPin* pin)
+{
+    pin = GetTextureSource(pin);
+    if (!pin)
+        return true;
+    if (pin->pNode->type == EditorNodeType::PROGRAM)
+        return false;
+    if (pin->pNode->type == EditorNodeType::IMAGE)
+        return ((EditorImageNode*)pin->pNode)->pinsIn[0]->connectedLinks.size() > 0;
+    return true;
+}
+
+EditorFrameValueSource ShaderNodeEditor::GetValueSource(EditorNode* node, EditorPin* pin)
+{
+    if (pin->connectedLinks.size() == 0)
+        return EditorFrameValueSource::PIN;
+
+    EditorNode* connectedNode = GetConnectedPin(node, pin->connectedLinks[0])->pNode;
+    if (pin->type == EditorPinType::FLOAT && connectedNode->type == EditorNodeType::TIME)
+        return EditorFrameValueSource::TIME;
+    if (pin->type == EditorPinType::FLOAT2 && connectedNode->type == EditorNodeType::MOUSE_POS)
+        return EditorFrameValueSource::MOUSE_POS;
+    return EditorFrameValueSource::PIN;
+}
+
+void ShaderNodeEditor::CompileProgramNode(EditorProgramNode* progNode, EditorFrameCommand& cmd)
+{
+    Program* program = progNode->target;
+    cmd.node = progNode;
+    cmd.program = program->GetProgram();
+    cmd.pipeline = program->GetPipeline();
+    if (cmd.pipeline != -1)
+        cmd.programs = program->GetStages();
+    else
+        cmd.programs.push_back(cmd.program);
+
+    // Render target
+    if (progNode->dispatchType == EditorProgramDispatchType::ARRAY)
+    {
+        cmd.framebuffer = progNode->framebuffer->GetFramebuffer();
+        if (cmd.framebuffer != 0)
+        {
+            progNode->framebuffer->GetSize(&cmd.viewport[0], &cmd.viewport[1]);
+            for (int i = 0; i < progNode->framebuffer->NumAttachments(); i++)
+                cmd.attachmentFormats.push_back(progNode->framebuffer->GetAttachmentFormat(i));
         }
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
 
     int textureCount = 0;
     int imageCount = 0;
     int uniformBlockIndex = 0;
     int storageBufferIndex = 0;
-    // Handle inputs
+    // Resolve inputs
     for (auto& pin : progNode->pinsIn)
     {
-        if (pin->type == EditorPinType::FLOAT)
+        if (pin->isSpecConstant)
+            continue;
+        else if (pin->type >= EditorPinType::FLOAT && pin->type <= EditorPinType::INT4)
         {
-            int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-            if (pin->connectedLinks.size() > 0)
-            {
-                EditorNode* connectedNode = GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
-                if (connectedNode->type == EditorNodeType::TIME)
-                {
-                    auto currentTime = std::chrono::high_resolution_clock::now();
-                    float value =
-                        std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - m_StartTime).count();
-                    value *= 0.001f;
-                    glUniform1f(loc, value);
-                }
-            }
-            else
-            {
-                EditorFloatPin* p = (EditorFloatPin*)pin;
-                glUniform1f(loc, p->value);
-            }
-        }
-        else if (pin->type == EditorPinType::FLOAT2)
-        {
-            int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-            if (pin->connectedLinks.size() > 0)
-            {
-                EditorNode* connectedNode = GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
-                if (connectedNode->type == EditorNodeType::MOUSE_POS)
-                {
-                    auto mousePos = ImGui::GetMousePos();
-                    glUniform2f(loc, mousePos.x / (float)m_RenderWidth, mousePos.y / (float)m_RenderHeight);
-                }
-            }
-            else
-            {
-                EditorFloat2Pin* p = (EditorFloat2Pin*)pin;
-                glUniform2f(loc, p->value[0], p->value[1]);
-            }
-        }
-        else if (pin->type == EditorPinType::FLOAT3)
-        {
-            int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-            EditorFloat3Pin* p = (EditorFloat3Pin*)pin;
-            glUniform3f(loc, p->value[0], p->value[1], p->value[2]);
-        }
-        else if (pin->type == EditorPinType::FLOAT4)
-        {
-            int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-            EditorFloat4Pin* p = (EditorFloat4Pin*)pin;
-            glUniform4f(loc, p->value[0], p->value[1], p->value[2], p->value[3]);
-        }
-        else if (pin->type == EditorPinType::INT)
-        {
-            int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-            EditorIntPin* p = (EditorIntPin*)pin;
-            glUniform1i(loc, p->value);
-        }
-        else if (pin->type == EditorPinType::INT2)
-        {
-            int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-            EditorInt2Pin* p = (EditorInt2Pin*)pin;
-            glUniform2i(loc, p->value[0], p->value[1]);
-        }
-        else if (pin->type == EditorPinType::INT3)
-        {
-            int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-            EditorInt3Pin* p = (EditorInt3Pin*)pin;
-            glUniform3i(loc, p->value[0], p->value[1], p->value[2]);
-        }
-        else if (pin->type == EditorPinType::INT4)
-        {
-            int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-            EditorInt4Pin* p = (EditorInt4Pin*)pin;
-            glUniform4i(loc, p->value[0], p->value[1], p->value[2], p->value[3]);
+            EditorFrameValueSource source = GetValueSource(progNode, pin);
+            // Linked pins without a known source keep the program's current value
+            if (pin->connectedLinks.size() > 0 && source == EditorFrameValueSource::PIN)
+                continue;
+
+            EditorFrameUniform uniform;
+            uniform.pin = pin;
+            uniform.source = source;
+            uniform.locs = program->GetUniformLocations(pin->name);
+            cmd.uniforms.push_back(uniform);
         }
 
         else if (pin->type == EditorPinType::TEXTURE)
@@ -1710,14 +1900,33 @@ void ShaderNodeEditor::ExecuteProgramNode(EditorProgramNode* progNode)
             if (pin->connectedLinks.size() > 0)
             {
                 GLuint texture = -1;
+                GLuint sampler = 0;
 
-                auto connectedNode = GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
-                if (connectedNode->type == EditorNodeType::PROGRAM)
+                // Sampler nodes in between only choose how the texture is sampled, the closest one wins
+                auto connectedPin = GetConnectedPin(progNode, pin->connectedLinks[0]);
+                for (int steps = 0; connectedPin->pNode->type == EditorNodeType::SAMPLER; steps++)
+                {
+                    // Guards against sampler loops from older graphs, which have no texture anyway
+                    if (steps >= m_Nodes.size())
+                    {
+                        connectedPin = 0;
+                        break;
+                    }
+                    auto samplerNode = (EditorSamplerNode*)connectedPin->pNode;
+                    if (sampler == 0)
+                        sampler = samplerNode->sampler;
+                    if (samplerNode->pinsIn[0]->connectedLinks.size() == 0)
+                        break;
+                    connectedPin = GetConnectedPin(samplerNode, samplerNode->pinsIn[0]->connectedLinks[0]);
+                }
+                EditorNode* connectedNode = connectedPin ? connectedPin->pNode : 0;
+                if (!connectedNode)
+                    texture = -1;
+                else if (connectedNode->type == EditorNodeType::PROGRAM)
                 {
                     auto connectedProgNode = (EditorProgramNode*)connectedNode;
-                    auto connectedPin = GetConnectedPin(progNode, pin->connectedLinks[0]);
-                    int attachmentIndex = connectedProgNode->attachmentsPinsStartId;
-                    for (int i = attachmentIndex; i < connectedProgNode->pinsOut.size(); i++)
+                    int attachmentIndex = 0;
+                    for (int i = connectedProgNode->attachmentsPinsStartId; i < connectedProgNode->pinsOut.size(); i++)
                     {
                         if (connectedProgNode->pinsOut[i] == connectedPin)
                             break;
@@ -1727,32 +1936,18 @@ void ShaderNodeEditor::ExecuteProgramNode(EditorProgramNode* progNode)
                     texture = connectedProgNode->framebuffer->GetTexture(attachmentIndex);
                 }
                 else if (connectedNode->type == EditorNodeType::TEXTURE)
-                {
-                    auto texNode = (EditorTextureNode*)connectedNode;
-
-                    texture = texNode->target->GetTexture();
-                }
+                    texture = ((EditorTextureNode*)connectedNode)->target->GetTexture();
                 else if (connectedNode->type == EditorNodeType::IMAGE)
-                {
-                    auto imgNode = (EditorImageNode*)connectedNode;
-
-                    if (imgNode->pinsIn[0]->connectedLinks.size() > 0)
-                    {
-                        auto texNode = (EditorTextureNode*)
-                            GetConnectedPin(imgNode, imgNode->pinsIn[0]->connectedLinks[0])->pNode;
-                        texture = texNode->target->GetTexture();
-                    }
-                    else
-                        texture = imgNode->texture;
-                }
+                    texture = GetImageNodeTexture((EditorImageNode*)connectedNode);
 
                 if (texture != -1)
                 {
-                    glActiveTexture(GL_TEXTURE0 + textureCount);
-                    glBindTexture(GL_TEXTURE_2D, texture);
-
-                    int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-                    glUniform1i(loc, textureCount);
+                    EditorFrameTexture frameTexture;
+                    frameTexture.texture = texture;
+                    frameTexture.sampler = sampler;
+                    frameTexture.unit = textureCount;
+                    frameTexture.locs = program->GetUniformLocations(pin->name);
+                    cmd.textures.push_back(frameTexture);
                     textureCount++;
                 }
             }
@@ -1762,28 +1957,27 @@ void ShaderNodeEditor::ExecuteProgramNode(EditorProgramNode* progNode)
         {
             if (pin->connectedLinks.size() > 0)
             {
-                EditorNode* connectedNode = GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
-                GetInputTargetNode(connectedNode, EditorPinType::IMAGE, imageCount);
-
-                if (connectedNode)
+                EditorFrameImage frameImage;
+                bool isBound = false;
+                for (int swap = 0; swap < 2; swap++)
                 {
-                    EditorImageNode* imgNode = (EditorImageNode*)connectedNode;
-
-                    if (imgNode->pinsIn[0]->connectedLinks.size() > 0)
-                    {
-                        EditorTextureNode* texNode = (EditorTextureNode*)
-                            GetConnectedPin(imgNode, imgNode->pinsIn[0]->connectedLinks[0])->pNode;
-                        //glBindTexture(GL_TEXTURE_2D, texNode->target->GetTexture());
-                        glBindImageTexture(textureCount, texNode->target->GetTexture(), 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA8);
-                    }
-                    else
+                    EditorNode* connectedNode = GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
+                    GetInputTargetNode(connectedNode, EditorPinType::IMAGE, imageCount, swap);
+                    if (connectedNode)
                     {
-                        //glBindTexture(GL_TEXTURE_2D, imgNode->texture);
-                        glBindImageTexture(textureCount, imgNode->texture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA8);
+                        auto imgNode = (EditorImageNode*)connectedNode;
+                        frameImage.texture[swap] = GetImageNodeTexture(imgNode);
+                        CheckImageFormat(imgNode, progNode, pin);
+                        isBound = true;
                     }
+                }
 
-                    int loc = glGetUniformLocation(progNode->target->GetProgram(), pin->name.c_str());
-                    glUniform1i(loc, textureCount);
+                if (isBound)
+                {
+                    frameImage.unit = textureCount;
+                    frameImage.format = program->GetImageFormat(pin->name);
+                    frameImage.locs = program->GetUniformLocations(pin->name);
+                    cmd.images.push_back(frameImage);
                     textureCount++;
                 }
             }
@@ -1795,145 +1989,48 @@ void ShaderNodeEditor::ExecuteProgramNode(EditorProgramNode* progNode)
             EditorBlockPin* p = (EditorBlockPin*)pin;
             if (pin->connectedLinks.size() > 0)
             {
-                EditorNode* connectedNode = GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
-                GetInputTargetNode(connectedNode, EditorPinType::BLOCK, storageBufferIndex);
-
-                if (connectedNode)
+                EditorFrameBlock frameBlock;
+                frameBlock.blockPinType = p->blockPinType;
+                bool isBound = false;
+                for (int swap = 0; swap < 2; swap++)
                 {
-                    EditorBlockNode* blockNode = (EditorBlockNode*)
-                        GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
+                    EditorNode* connectedNode = GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
+                    GetInputTargetNode(connectedNode, EditorPinType::BLOCK, storageBufferIndex, swap);
+                    if (!connectedNode)
+                        continue;
+
+                    EditorBlockNode* blockNode = (EditorBlockNode*)connectedNode;
+                    frameBlock.target[swap] = blockNode;
+                    isBound = true;
                     if (p->blockPinType == EditorBlockPinType::UNIFROM_BLOCK)
                     {
-                        GLuint blockId =
-                            glGetUniformBlockIndex(progNode->target->GetProgram(), pin->name.c_str());
-                        GLuint binding = progNode->target->GetUniformBlocks()[uniformBlockIndex].GetBinding();
-                        glUniformBlockBinding(progNode->target->GetProgram(), blockId, binding);
-                        glBindBufferBase(GL_UNIFORM_BUFFER, binding, blockNode->ubo);
-
-                        GLubyte* blockData = (GLubyte*)glMapBufferRange
-                        (
-                            GL_UNIFORM_BUFFER, 0, blockNode->size,
-                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
-                        );
-                        int offset = 0;
-                        for (int i = 0; i < blockNode->pinsIn.size(); i++)
+                        for (auto& blockPin : blockNode->pinsIn)
                         {
-                            if (blockNode->pinsIn[i]->type == EditorPinType::FLOAT)
-                            {
-                                if (blockNode->pinsIn[i]->connectedLinks.size() > 0)
-                                {
-                                    EditorNode* connectedNode =
-                                        GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
-                                    if (connectedNode->type == EditorNodeType::TIME)
-                                    {
-                                        auto currentTime = std::chrono::high_resolution_clock::now();
-                                        float value =
-                                            std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - m_StartTime).count();
-                                        value *= 0.001f;
-                                        memcpy(blockData + offset, &value, sizeof(float));
-                                    }
-                                }
-                                else
-                                {
-                                    auto blockPin = (EditorFloatPin*)blockNode->pinsIn[i];
-                                    memcpy(blockData + offset, &blockPin->value, sizeof(float));
-                                }
-                                offset += sizeof(float);
-                            }
-                            else if (blockNode->pinsIn[i]->type == EditorPinType::FLOAT2)
-                            {
-                                if (blockNode->pinsIn[i]->connectedLinks.size() > 0)
-                                {
-                                    EditorNode* connectedNode =
-                                        GetConnectedPin(progNode, pin->connectedLinks[0])->pNode;
-                                    if (connectedNode->type == EditorNodeType::MOUSE_POS)
-                                    {
-                                        auto mousePos = ImGui::GetMousePos();
-                                        float x = mousePos.x / (float)m_RenderWidth;
-                                        memcpy(blockData + offset, &x, sizeof(float));
-                                        offset += sizeof(float);
-                                        float y = mousePos.y / (float)m_RenderHeight;
-                                        memcpy(blockData + offset, &y, sizeof(float));
-                                        offset += sizeof(float);
-                                    }
-                                }
-                                else
-                                {
-                                    auto blockPin = (EditorFloat2Pin*)blockNode->pinsIn[i];
-                                    memcpy(blockData + offset, &blockPin->value[0], sizeof(float));
-                                    offset += sizeof(float);
-                                    memcpy(blockData + offset, &blockPin->value[1], sizeof(float));
-                                    offset += sizeof(float);
-                                }
-                            }
-                            else if (blockNode->pinsIn[i]->type == EditorPinType::FLOAT3)
-                            {
-                                auto blockPin = (EditorFloat3Pin*)blockNode->pinsIn[i];
-                                memcpy(blockData + offset, &blockPin->value[0], sizeof(float));
-                                offset += sizeof(float);
-                                memcpy(blockData + offset, &blockPin->value[1], sizeof(float));
-                                offset += sizeof(float);
-                                memcpy(blockData + offset, &blockPin->value[2], sizeof(float));
-                                offset += sizeof(float);
-                            }
-                            else if (blockNode->pinsIn[i]->type == EditorPinType::FLOAT4)
-                            {
-                                auto blockPin = (EditorFloat4Pin*)blockNode->pinsIn[i];
-                                memcpy(blockData + offset, &blockPin->value[0], sizeof(float));
-                                offset += sizeof(float);
-                                memcpy(blockData + offset, &blockPin->value[1], sizeof(float));
-                                offset += sizeof(float);
-                                memcpy(blockData + offset, &blockPin->value[2], sizeof(float));
-                                offset += sizeof(float);
-                                memcpy(blockData + offset, &blockPin->value[3], sizeof(float));
-                                offset += sizeof(float);
-                            }
-                            else if (blockNode->pinsIn[i]->type == EditorPinType::INT)
-                            {
-                                auto blockPin = (EditorIntPin*)blockNode->pinsIn[i];
-                                memcpy(blockData + offset, &blockPin->value, sizeof(int));
-                                offset += sizeof(int);
-                            }
-                            else if (blockNode->pinsIn[i]->type == EditorPinType::INT2)
-                            {
-                                auto blockPin = (EditorInt2Pin*)blockNode->pinsIn[i];
-                                memcpy(blockData + offset, &blockPin->value[0], sizeof(int));
-                                offset += sizeof(int);
-                                memcpy(blockData + offset, &blockPin->value[1], sizeof(int));
-                                offset += sizeof(int);
-                            }
-                            else if (blockNode->pinsIn[i]->type == EditorPinType::INT3)
-                            {
-                                auto blockPin = (EditorInt3Pin*)blockNode->pinsIn[i];
-                                memcpy(blockData + offset, &blockPin->value[0], sizeof(int));
-                                offset += sizeof(int);
-                                memcpy(blockData + offset, &blockPin->value[1], sizeof(int));
-                                offset += sizeof(int);
-                                memcpy(blockData + offset, &blockPin->value[2], sizeof(int));
-                                offset += sizeof(int);
-                            }
-                            else if (blockNode->pinsIn[i]->type == EditorPinType::INT4)
-                            {
-                                auto blockPin = (EditorInt4Pin*)blockNode->pinsIn[i];
-                                memcpy(blockData + offset, &blockPin->value[0], sizeof(int));
-                                offset += sizeof(int);
-                                memcpy(blockData + offset, &blockPin->value[1], sizeof(int));
-                                offset += sizeof(int);
-                                memcpy(blockData + offset, &blockPin->value[2], sizeof(int));
-                                offset += sizeof(int);
-                                memcpy(blockData + offset, &blockPin->value[3], sizeof(int));
-                                offset += sizeof(int);
-                            }
+                            EditorFrameUniform member;
+                            member.pin = blockPin;
+                            member.source = GetValueSource(blockNode, blockPin);
+                            if (member.source != EditorFrameValueSource::PIN)
+                                frameBlock.isDynamic[swap] = true;
+                            frameBlock.members[swap].push_back(member);
                         }
+                    }
+                }
 
-                        glUnmapBuffer(GL_UNIFORM_BUFFER);
+                if (isBound)
+                {
+                    if (p->blockPinType == EditorBlockPinType::UNIFROM_BLOCK)
+                    {
+                        const UniformBlock& block = program->GetUniformBlock(uniformBlockIndex);
+                        frameBlock.locations = block.GetLocations();
+                        frameBlock.binding = block.GetBinding();
                     }
                     else
                     {
-                        glBindBuffer(GL_SHADER_STORAGE_BUFFER, blockNode->ssbo);
-                        GLuint binding = progNode->target->GetBufferBlocks()[storageBufferIndex].GetBinding();
-                        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, blockNode->ssbo);
+                        const BufferBlock& block = program->GetBufferBlock(storageBufferIndex);
+                        frameBlock.locations = block.GetLocations();
+                        frameBlock.binding = block.GetBinding();
                     }
+                    cmd.blocks.push_back(frameBlock);
                 }
             }
 
@@ -1943,30 +2040,423 @@ void ShaderNodeEditor::ExecuteProgramNode(EditorProgramNode* progNode)
                 storageBufferIndex++;
         }
     }
-
-    // Dispatch
-    if (progNode->dispatchType == EditorProgramDispatchType::ARRAY)
-        glDrawArrays(progNode->drawMode, 0, progNode->dispatchSize[0]);
-    else if (progNode->dispatchType == EditorProgramDispatchType::COMPUTE)
+}
+
+void ShaderNodeEditor::CompileFlow(EditorEventNode* eventNode, std::vector<EditorFrameCommand>& plan)
+{
+    std::vector<EditorFrameCommand>().swap(plan);
+
+    EditorProgramNode* progNode = 0;
+    if (eventNode->pinsOut[0]->connectedLinks.size() > 0)
+    {
+        progNode = (EditorProgramNode*)
+            GetConnectedPin(eventNode, eventNode->pinsOut[0]->connectedLinks[0])->pNode;
+    }
+    // A flow can not be longer than the number of nodes, anything beyond is a loop
+    for (int steps = 0; progNode && steps < m_Nodes.size(); steps++)
+    {
+        // Programs still compiling for the first time are left out until they are linked
+        if (progNode->target->IsLinked())
+        {
+            plan.emplace_back();
+            CompileProgramNode(progNode, plan.back());
+        }
+
+        if (progNode->flowOut->connectedLinks.size() > 0)
+        {
+            progNode = (EditorProgramNode*)
+                GetConnectedPin(progNode, progNode->flowOut->connectedLinks[0])->pNode;
+        }
+        else
+            progNode = 0;
+    }
+}
+
+void ShaderNodeEditor::CheckImageFormat(EditorImageNode* imgNode, EditorProgramNode* progNode, EditorPin* pin)
+{
+    // Image units only accept a format with the texel size of the texture's storage.
+    // Image nodes fed by a loaded texture are left out, its format is not known here
+    if (imgNode->pinsIn[0]->connectedLinks.size() > 0)
+        return;
+    const TextureFormat::Info& storage = TextureFormat::Get(TextureFormat::IndexOf(imgNode->format));
+    const TextureFormat::Info& shader = TextureFormat::Get(TextureFormat::IndexOf(progNode->target->GetImageFormat(pin->name)));
+    if (shader.pixelSize == storage.pixelSize)
+        return;
+    std::string warning = progNode->target->GetName() + ": " + pin->name + " is declared " + shader.qualifier + " (" +
+        std::to_string(shader.pixelSize) + " bytes per texel), the image is " + storage.name + " (" +
+        std::to_string(storage.pixelSize) + " bytes per texel)\n";
+    if (imgNode->formatWarning.find(warning) == std::string::npos)
+        imgNode->formatWarning += warning;
+}
+
+void ShaderNodeEditor::CompileFramePlans()
+{
+    // A sampler's source may have been relinked or reallocated since its filters were set
+    for (auto& node : m_Nodes)
+    {
+        if (node->type == EditorNodeType::IMAGE)
+            ((EditorImageNode*)node)->formatWarning = "";
+        else if (node->type == EditorNodeType::SAMPLER)
+            UpdateSamplerNode((EditorSamplerNode*)node);
+    }
+    CompileFlow((EditorEventNode*)m_Nodes[0], m_InitPlan);
+    CompileFlow((EditorEventNode*)m_Nodes[1], m_FramePlan);
+    m_FramePlanDirty = false;
+
+    // Queries in flight were recorded against the old node ids
+    m_GpuTimer.Discard();
+    m_GpuFrameTimes.clear();
+
+    std::unordered_map<GLuint, int> programUses;
+    for (auto plan : { &m_InitPlan, &m_FramePlan })
+    {
+        for (auto& cmd : *plan)
+        {
+            for (auto program : cmd.programs)
+                programUses[program]++;
+        }
+    }
+
+    // Reserve enough ring space for a frame that runs both flows
+    GLsizeiptr uniformSize = 0;
+    for (auto plan : { &m_InitPlan, &m_FramePlan })
+    {
+        for (auto& cmd : *plan)
+        {
+            for (auto program : cmd.programs)
+                cmd.isProgramShared = cmd.isProgramShared || programUses[program] > 1;
+
+            // Sampler and image units are fixed by the plan
+            for (auto& texture : cmd.textures)
+            {
+                for (auto& location : texture.locs)
+                    glProgramUniform1i(location.program, location.index, texture.unit);
+            }
+            for (auto& image : cmd.images)
+            {
+                for (auto& location : image.locs)
+                    glProgramUniform1i(location.program, location.index, image.unit);
+            }
+
+            // The plan may have been rebuilt around relinked programs or new links,
+            // so everything it feeds is uploaded once more
+            for (auto& uniform : cmd.uniforms)
+                uniform.pin->dirty = true;
+            for (auto& block : cmd.blocks)
+            {
+                if (block.blockPinType != EditorBlockPinType::UNIFROM_BLOCK)
+                    continue;
+                int size = 0;
+                for (int i = 0; i < 2; i++)
+                {
+                    if (!block.target[i])
+                        continue;
+                    block.target[i]->dirty = true;
+                    for (auto& member : block.members[i])
+                        member.pin->dirty = true;
+                    if (block.isDynamic[i] && block.target[i]->size > size)
+                        size = block.target[i]->size;
+                }
+                uniformSize += m_UniformRing.Align(size);
+            }
+        }
+    }
+    m_UniformRing.Reserve(uniformSize);
+}
+
+void ShaderNodeEditor::PackBlockNode(const EditorFrameBlock& block, int swap, float time, const float* mouse)
+{
+    // Pack changed members into the block's staging image at their laid out offsets
+    EditorBlockNode* blockNode = block.target[swap];
+    GLubyte* blockData = blockNode->data.data();
+    for (auto& member : block.members[swap])
+    {
+        EditorPin* pin = member.pin;
+        if (member.source == EditorFrameValueSource::PIN && !pin->dirty && !blockNode->dirty)
+            continue;
+        pin->dirty = false;
+        int offset = pin->offset;
+        int size = EditorNodeUtil::PinTypeSize(pin->type);
+        if (offset < 0 || offset + size > blockNode->data.size())
+            continue;
+        if (member.source == EditorFrameValueSource::TIME)
+            memcpy(blockData + offset, &time, size);
+        else if (member.source == EditorFrameValueSource::MOUSE_POS)
+            memcpy(blockData + offset, mouse, size);
+        else if (pin->connectedLinks.size() == 0)
+        {
+            if (pin->type == EditorPinType::FLOAT)
+                memcpy(blockData + offset, &((EditorFloatPin*)pin)->value, size);
+            else if (pin->type == EditorPinType::FLOAT2)
+                memcpy(blockData + offset, ((EditorFloat2Pin*)pin)->value, size);
+            else if (pin->type == EditorPinType::FLOAT3)
+                memcpy(blockData + offset, ((EditorFloat3Pin*)pin)->value, size);
+            else if (pin->type == EditorPinType::FLOAT4)
+                memcpy(blockData + offset, ((EditorFloat4Pin*)pin)->value, size);
+            else if (pin->type == EditorPinType::INT)
+                memcpy(blockData + offset, &((EditorIntPin*)pin)->value, size);
+            else if (pin->type == EditorPinType::INT2)
+                memcpy(blockData + offset, ((EditorInt2Pin*)pin)->value, size);
+            else if (pin->type == EditorPinType::INT3)
+                memcpy(blockData + offset, ((EditorInt3Pin*)pin)->value, size);
+            else if (pin->type == EditorPinType::INT4)
+                memcpy(blockData + offset, ((EditorInt4Pin*)pin)->value, size);
+        }
+    }
+    blockNode->dirty = false;
+}
+
+void ShaderNodeEditor::ExecuteFrameCommand(const EditorFrameCommand& cmd)
+{
+    EditorProgramNode* progNode = cmd.node;
+    int swap = m_PingPongSwap ? 1 : 0;
+
+    auto currentTime = std::chrono::high_resolution_clock::now();
+    float time = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - m_StartTime).count();
+    time *= 0.001f;
+    auto mousePos = ImGui::GetMousePos();
+    float mouse[2] = { mousePos.x / (float)m_RenderWidth, mousePos.y / (float)m_RenderHeight };
+
+    // Uniforms, these target the programs directly and need no bind
+    for (auto& uniform : cmd.uniforms)
+    {
+        EditorPin* pin = uniform.pin;
+        // Static values stay in the program until they are edited
+        if (uniform.source == EditorFrameValueSource::PIN && !pin->dirty && !cmd.isProgramShared)
+            continue;
+        pin->dirty = false;
+        for (auto& location : uniform.locs)
+        {
+            GLuint program = location.program;
+            int loc = location.index;
+            m_NumUniformUploads++;
+            if (uniform.source == EditorFrameValueSource::TIME)
+                glProgramUniform1f(program, loc, time);
+            else if (uniform.source == EditorFrameValueSource::MOUSE_POS)
+                glProgramUniform2f(program, loc, mouse[0], mouse[1]);
+            else if (pin->type == EditorPinType::FLOAT)
+                glProgramUniform1f(program, loc, ((EditorFloatPin*)pin)->value);
+            else if (pin->type == EditorPinType::FLOAT2)
+                glProgramUniform2fv(program, loc, 1, ((EditorFloat2Pin*)pin)->value);
+            else if (pin->type == EditorPinType::FLOAT3)
+                glProgramUniform3fv(program, loc, 1, ((EditorFloat3Pin*)pin)->value);
+            else if (pin->type == EditorPinType::FLOAT4)
+                glProgramUniform4fv(program, loc, 1, ((EditorFloat4Pin*)pin)->value);
+            else if (pin->type == EditorPinType::INT)
+                glProgramUniform1i(program, loc, ((EditorIntPin*)pin)->value);
+            else if (pin->type == EditorPinType::INT2)
+                glProgramUniform2iv(program, loc, 1, ((EditorInt2Pin*)pin)->value);
+            else if (pin->type == EditorPinType::INT3)
+                glProgramUniform3iv(program, loc, 1, ((EditorInt3Pin*)pin)->value);
+            else if (pin->type == EditorPinType::INT4)
+                glProgramUniform4iv(program, loc, 1, ((EditorInt4Pin*)pin)->value);
+        }
+    }
+
+    m_GpuTimer.BeginSection(progNode->id);
+
+    // Setup program, a program in use would take precedence over the pipeline
+    if (cmd.pipeline != -1)
+    {
+        m_GLState.UseProgram(0);
+        m_GLState.BindProgramPipeline(cmd.pipeline);
+    }
+    else
+        m_GLState.UseProgram(cmd.program);
+    if (progNode->dispatchType == EditorProgramDispatchType::ARRAY)
+    {
+        m_GLState.BindFramebuffer(cmd.framebuffer);
+        if (cmd.framebuffer == 0)
+            m_GLState.Viewport(0, 0, m_RenderWidth, m_RenderHeight);
+        else
+            m_GLState.Viewport(0, 0, cmd.viewport[0], cmd.viewport[1]);
+        if (cmd.framebuffer == 0)
+        {
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+        else
+        {
+            // glClear writes float colors, which leaves integer attachments undefined
+            GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            const GLint clearInt[4] = { 0, 0, 0, 1 };
+            const GLuint clearUint[4] = { 0, 0, 0, 1 };
+            GLfloat clearDepth = 1.0f;
+            for (int i = 0; i < cmd.attachmentFormats.size(); i++)
+            {
+                GLenum type = TextureFormat::Get(TextureFormat::IndexOf(cmd.attachmentFormats[i])).type;
+                if (!TextureFormat::IsInteger(cmd.attachmentFormats[i]))
+                    glClearNamedFramebufferfv(cmd.framebuffer, GL_COLOR, i, clearColor);
+                else if (type == GL_INT)
+                    glClearNamedFramebufferiv(cmd.framebuffer, GL_COLOR, i, clearInt);
+                else
+                    glClearNamedFramebufferuiv(cmd.framebuffer, GL_COLOR, i, clearUint);
+            }
+            glClearNamedFramebufferfv(cmd.framebuffer, GL_DEPTH, 0, &clearDepth);
+        }
+    }
+
+    // Textures
+    for (auto& texture : cmd.textures)
+    {
+        m_GLState.BindTexture(texture.unit, texture.texture);
+        m_GLState.BindSampler(texture.unit, texture.sampler);
+        if (cmd.isProgramShared)
+        {
+            for (auto& location : texture.locs)
+                glProgramUniform1i(location.program, location.index, texture.unit);
+        }
+    }
+
+    // Images
+    for (auto& image : cmd.images)
+    {
+        if (image.texture[swap] == -1)
+            continue;
+        m_GLState.BindImageTexture(image.unit, image.texture[swap], 0, GL_FALSE, 0, GL_READ_WRITE, image.format);
+        if (cmd.isProgramShared)
+        {
+            for (auto& location : image.locs)
+                glProgramUniform1i(location.program, location.index, image.unit);
+        }
+    }
+
+    // Blocks
+    for (auto& block : cmd.blocks)
+    {
+        EditorBlockNode* blockNode = block.target[swap];
+        if (!blockNode)
+            continue;
+
+        // Stage programs are shared between pipelines, another one may have moved the block's binding
+        if (cmd.pipeline != -1 && cmd.isProgramShared)
+        {
+            for (auto& location : block.locations)
+            {
+                if (block.blockPinType == EditorBlockPinType::BUFFER_BLOCK)
+                    glShaderStorageBlockBinding(location.program, location.index, block.binding);
+                else
+                    glUniformBlockBinding(location.program, location.index, block.binding);
+            }
+        }
+
+        if (block.blockPinType == EditorBlockPinType::BUFFER_BLOCK)
+        {
+            m_GLState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, block.binding, blockNode->ssbo);
+            continue;
+        }
+
+        if (!block.isDynamic[swap])
+        {
+            if (blockNode->dirty)
+            {
+                PackBlockNode(block, swap, time, mouse);
+                glNamedBufferSubData(blockNode->ubo, 0, blockNode->size, blockNode->data.data());
+                m_NumBlockUploads++;
+            }
+            m_GLState.BindBufferBase(GL_UNIFORM_BUFFER, block.binding, blockNode->ubo);
+            continue;
+        }
+
+        PackBlockNode(block, swap, time, mouse);
+
+        // Upload the whole image with a single copy
+        GLubyte* ringData = 0;
+        GLintptr ringOffset = m_UniformRing.Allocate(blockNode->size, &ringData);
+        if (ringOffset == -1)
+            continue;
+        memcpy(ringData, blockNode->data.data(), blockNode->size);
+        m_NumBlockUploads++;
+        m_GLState.BindBufferRange
+        (
+            GL_UNIFORM_BUFFER, block.binding,
+            m_UniformRing.GetBuffer(), ringOffset, blockNode->size
+        );
+    }
+
+    // Barriers, only for inputs an earlier command wrote through image stores or storage buffers
+    for (auto& texture : cmd.textures)
+        m_Barriers.ReadTexture(texture.texture, GL_TEXTURE_FETCH_BARRIER_BIT);
+    for (auto& image : cmd.images)
+    {
+        if (image.texture[swap] != -1)
+            m_Barriers.ReadTexture(image.texture[swap], GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    for (auto& block : cmd.blocks)
+    {
+        if (block.blockPinType == EditorBlockPinType::BUFFER_BLOCK && block.target[swap])
+            m_Barriers.ReadBuffer(block.target[swap]->ssbo, GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    m_Barriers.Flush();
+
+    // Dispatch
+    if (progNode->dispatchType == EditorProgramDispatchType::ARRAY)
+        glDrawArrays(progNode->drawMode, 0, progNode->dispatchSize[0]);
+    else if (progNode->dispatchType == EditorProgramDispatchType::COMPUTE)
+    {
+        glDispatchCompute
+        (
+            progNode->dispatchSize[0],
+            progNode->dispatchSize[1],
+            progNode->dispatchSize[2]
+        );
+    }
+    m_GpuTimer.EndSection();
+
+    // Images and storage buffers are bound read-write, so any of them may have been written
+    for (auto& image : cmd.images)
+    {
+        if (image.texture[swap] != -1)
+            m_Barriers.WriteTexture(image.texture[swap]);
+    }
+    for (auto& block : cmd.blocks)
+    {
+        if (block.blockPinType == EditorBlockPinType::BUFFER_BLOCK && block.target[swap])
+            m_Barriers.WriteBuffer(block.target[swap]->ssbo);
+    }
+}
+
+void ShaderNodeEditor::ExecutePlan(const std::vector<EditorFrameCommand>& plan)
+{
+    for (auto& cmd : plan)
+        ExecuteFrameCommand(cmd);
+}
+
+void ShaderNodeEditor::RecordGpuTime(EditorProgramNode* node, float time)
+{
+    // The sum and the sorted copy are updated with the one sample that changed,
+    // so a frame costs no allocation and no full sort
+    const int windowSize = 64;
+    EditorTimingStats& stats = node->gpuTime;
+    if (stats.samples.size() < windowSize)
+    {
+        stats.samples.reserve(windowSize);
+        stats.sorted.reserve(windowSize);
+        stats.samples.push_back(time);
+    }
+    else
     {
-        glDispatchCompute
-        (
-            progNode->dispatchSize[0],
-            progNode->dispatchSize[1],
-            progNode->dispatchSize[2]
-        );
-        glMemoryBarrier
-        (
-            GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
-            GL_SHADER_STORAGE_BARRIER_BIT |
-            GL_BUFFER_UPDATE_BARRIER_BIT
-        );
+        float replaced = stats.samples[stats.next];
+        stats.sum -= replaced;
+        stats.sorted.erase(std::lower_bound(stats.sorted.begin(), stats.sorted.end(), replaced));
+        stats.samples[stats.next] = time;
     }
+    stats.next = (stats.next + 1) % windowSize;
+    stats.sum += time;
+    stats.sorted.insert(std::upper_bound(stats.sorted.begin(), stats.sorted.end(), time), time);
+
+    stats.average = (float)(stats.sum / stats.samples.size());
+    stats.p95 = stats.sorted[(stats.sorted.size() - 1) * 95 / 100];
 }
 
 void ShaderNodeEditor::Initialize()
 {
     ConfigImGui();
+    EnableParallelShaderCompile();
+
+    // Core profiles can't draw without a vertex array, attributeless draws get an empty one
+    if (m_EmptyVertexArray == -1)
+        glCreateVertexArrays(1, &m_EmptyVertexArray);
 
     ImNodes::CreateContext();
     ImNodes::GetIO().AltMouseButton = ImGuiMouseButton_Right;
@@ -2035,6 +2525,7 @@ void ShaderNodeEditor::Initialize()
     m_Nodes.push_back(onFrameNode);
 
     m_StartTime = std::chrono::high_resolution_clock::now();
+    m_FramePlanDirty = true;
 }
 
 void ShaderNodeEditor::SetRenderSize(int width, int height)
@@ -2043,15 +2534,77 @@ void ShaderNodeEditor::SetRenderSize(int width, int height)
 	m_RenderHeight = height;
 }
 
+void ShaderNodeEditor::ResetRuntimeState()
+{
+    // Restarting replays On Init against fresh contents, without touching the graph
+    m_StartTime = std::chrono::high_resolution_clock::now();
+    m_PingPongSwap = false;
+    // Shader writes from the previous run must land before the clears
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    for (auto& node : m_Nodes)
+    {
+        if (node->type == EditorNodeType::BLOCK)
+        {
+            EditorBlockNode* blockNode = (EditorBlockNode*)node;
+            glClearNamedBufferData(blockNode->ssbo, GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE, NULL);
+        }
+        else if (node->type == EditorNodeType::IMAGE)
+        {
+            EditorImageNode* imageNode = (EditorImageNode*)node;
+            auto& format = TextureFormat::Get(TextureFormat::IndexOf(imageNode->format));
+            if (imageNode->sizeX > 0 && imageNode->sizeY > 0)
+                glClearTexImage(imageNode->texture, 0, format.format, format.type, NULL);
+        }
+    }
+}
+
+void ShaderNodeEditor::UpdateWatchedFiles()
+{
+    std::vector<std::string> files;
+    for (auto program : m_Programs)
+    {
+        const std::vector<std::string>& shaderFiles = program->GetShaderFiles();
+        files.insert(files.end(), shaderFiles.begin(), shaderFiles.end());
+        for (auto& stageFiles : program->GetSourceFiles())
+            files.insert(files.end(), stageFiles.begin(), stageFiles.end());
+    }
+    m_FileWatcher.SetFiles(files);
+}
+
 void ShaderNodeEditor::Display()
 {
     // Update nodes
+    // Programs are all submitted first and polled every frame, so sources are
+    // read by the workers and compiled by the driver while the editor keeps running
     bool needsUpdate = false;
+    bool isCompiling = false;
+    bool needsWatchUpdate = false;
+
+    // A changed shader or include only reloads the programs built from it,
+    // the rest of the running graph is left alone
+    std::vector<std::string> changedFiles;
+    m_FileWatcher.Poll(changedFiles);
+    for (auto& file : changedFiles)
+        Preprocessor::Invalidate(file);
+
     for (int i = 0; i < m_Programs.size(); i++)
     {
-        if (m_Programs[i]->NeedsInit() || m_OnInit)
+        bool isChanged = false;
+        for (auto& file : changedFiles)
+            isChanged = isChanged || m_Programs[i]->DependsOn(file);
+
+        // Restarting only resubmits programs whose sources changed on disk
+        if (m_Programs[i]->NeedsInit())
+        {
+            m_Programs[i]->Initialize(m_Workers);
+            needsWatchUpdate = true;
+        }
+        else if ((m_OnInit && !m_IsWaitingForPrograms) || isChanged)
+            m_Programs[i]->Reload(m_Workers);
+        if (m_Programs[i]->Poll())
         {
-            m_Programs[i]->Initialize();
+            needsWatchUpdate = true;
+            m_FramePlanDirty = true;
             for (auto& node : m_Nodes)
             {
                 if (node->type == EditorNodeType::PROGRAM)
@@ -2059,18 +2612,23 @@ void ShaderNodeEditor::Display()
                     EditorProgramNode* progNode = (EditorProgramNode*)node;
                     if (progNode->target == m_Programs[i])
                     {
-                        UpdateProgramNode(node->id, i);
-                        needsUpdate = true;
+                        if (UpdateProgramNode(node->id, i))
+                            needsUpdate = true;
                     }
                 }
             }
         }
+        if (m_Programs[i]->IsPending())
+            isCompiling = true;
     }
+    if (needsWatchUpdate)
+        UpdateWatchedFiles();
     for (int i = 0; i < m_Framebuffers.size(); i++)
     {
         if (m_Framebuffers[i]->NeedsInit())
         {
             m_Framebuffers[i]->Initialize();
+            m_FramePlanDirty = true;
             for (auto& node : m_Nodes)
             {
                 if (node->type == EditorNodeType::PROGRAM)
@@ -2091,66 +2649,66 @@ void ShaderNodeEditor::Display()
         UpdateLinks();
     }
 
-    if (m_OnInit)
+    // Textures are decoded by the workers and streamed in over several frames,
+    // nodes sample the placeholder until theirs is swapped in.
+    // Restarting only uploads textures whose file changed
+    for (auto texture : m_Textures)
     {
-        for (auto texture : m_Textures)
-            texture->LoadFromFile(texture->GetPath().c_str());
+        if (m_OnInit && !m_IsWaitingForPrograms)
+            texture->Reload(m_Workers, m_TextureUploader);
+        if (texture->Poll())
+            m_FramePlanDirty = true;
     }
+    m_TextureUploader.Update();
 
     if (!m_IsPlaying)
     {
         m_OnInit = false;
+        m_IsWaitingForPrograms = false;
         return;
     }
 
-    // Execute on init
-    if (m_OnInit)
-    {
-        m_StartTime = std::chrono::high_resolution_clock::now();
+    // On Init has to run against the new programs, hold the restart until they are linked
+    m_IsWaitingForPrograms = m_OnInit && isCompiling;
+    if (m_IsWaitingForPrograms)
+        return;
 
-        EditorProgramNode* progNode = 0;
-        EditorEventNode* onInitNode = (EditorEventNode*)m_Nodes[0];
-        if (onInitNode->pinsOut[0]->connectedLinks.size() > 0)
-        {
-            progNode = (EditorProgramNode*)
-                GetConnectedPin(onInitNode, onInitNode->pinsOut[0]->connectedLinks[0])->pNode;
-        }
-        while (progNode)
-        {
-            ExecuteProgramNode(progNode);
+    if (m_FramePlanDirty)
+        CompileFramePlans();
 
-            if (progNode->flowOut->connectedLinks.size() > 0)
-            {
-                progNode = (EditorProgramNode*)
-                    GetConnectedPin(progNode, progNode->flowOut->connectedLinks[0])->pNode;
-            }
-            else
-                progNode = 0;
-        }
+    // Anything outside the plans may have changed the bindings since last frame
+    m_GLState.Invalidate();
+    m_GLState.ResetStats();
+    glBindVertexArray(m_EmptyVertexArray);
+    m_Barriers.ResetStats();
 
-        m_OnInit = false;
+    // Read back the frame that last used this query slot, if the GPU is done with it.
+    // Both buffers keep their capacity, nothing is allocated once they have grown
+    if (m_GpuTimer.BeginFrame(m_GpuResolvedTimes))
+    {
+        m_GpuFrameTimes.swap(m_GpuResolvedTimes);
+        for (auto& time : m_GpuFrameTimes)
+        {
+            if (time.first < m_Nodes.size() && m_Nodes[time.first]->type == EditorNodeType::PROGRAM)
+                RecordGpuTime((EditorProgramNode*)m_Nodes[time.first], time.second);
+        }
     }
+    m_NumUniformUploads = 0;
+    m_NumBlockUploads = 0;
+    m_UniformRing.BeginFrame();
 
-    // Execute on frame
-    EditorProgramNode* progNode = 0;
-    EditorEventNode* onFrameNode = (EditorEventNode*)m_Nodes[1];
-    if (onFrameNode->pinsOut[0]->connectedLinks.size() > 0)
+    // Execute on init
+    if (m_OnInit)
     {
-        progNode = (EditorProgramNode*)
-            GetConnectedPin(onFrameNode, onFrameNode->pinsOut[0]->connectedLinks[0])->pNode;
+        ResetRuntimeState();
+        ExecutePlan(m_InitPlan);
+        m_OnInit = false;
     }
-    while (progNode)
-    {
-        ExecuteProgramNode(progNode);
 
-        if (progNode->flowOut->connectedLinks.size() > 0)
-        {
-            progNode = (EditorProgramNode*)
-                GetConnectedPin(progNode, progNode->flowOut->connectedLinks[0])->pNode;
-        }
-        else
-            progNode = 0;
-    }
+    // Execute on frame
+    ExecutePlan(m_FramePlan);
+    m_UniformRing.EndFrame();
+    m_GpuTimer.EndFrame();
 
     m_PingPongSwap = !m_PingPongSwap;
 }
@@ -2279,7 +2837,14 @@ void ShaderNodeEditor::DrawGui()
                     name += "##program" + std::to_string(i);
                     bool isSelected = m_SelectedItemType == SelectedItemType::PROGRAM;
                     isSelected = isSelected && (m_SelectedItemId == i);
-                    if (ImGui::Selectable(name.c_str(), &isSelected))
+                    // Programs whose last build failed
+                    bool hasError = !m_Programs[i]->GetErrorLog().empty();
+                    if (hasError)
+                        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
+                    bool isClicked = ImGui::Selectable(name.c_str(), &isSelected);
+                    if (hasError)
+                        ImGui::PopStyleColor();
+                    if (isClicked)
                     {
                         ImNodes::ClearLinkSelection();
                         ImNodes::ClearNodeSelection();
@@ -2511,11 +3076,27 @@ void ShaderNodeEditor::DrawGui()
                 ImNodes::BeginNodeTitleBar();
                 ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 0.0f));
                 ImGui::Text(progNode->target->GetName().c_str());
+                if (!progNode->target->GetErrorLog().empty())
+                {
+                    ImGui::SameLine();
+                    ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "  " ICON_FK_EXCLAMATION_TRIANGLE);
+                    if (ImGui::IsItemHovered())
+                        ImGui::SetTooltip("%s", progNode->target->GetErrorLog().c_str());
+                }
+                std::string gpuTimeStr = "";
+                if (m_IsPlaying && progNode->gpuTime.samples.size() > 0)
+                {
+                    char buf[64];
+                    snprintf(buf, sizeof(buf), "  %.2f ms (p95 %.2f)", progNode->gpuTime.average, progNode->gpuTime.p95);
+                    gpuTimeStr = buf;
+                    ImGui::SameLine();
+                    ImGui::TextDisabled(gpuTimeStr.c_str());
+                }
                 ImGui::PopStyleVar();
                 ImNodes::EndNodeTitleBar();
 
                 // Compute node width
-                float nodeWidth = ImGui::CalcTextSize(progNode->target->GetName().c_str()).x;
+                float nodeWidth = ImGui::CalcTextSize((progNode->target->GetName() + gpuTimeStr).c_str()).x;
                 float nodeInWidth = 0.0f;
                 float nodeOutWidth = 0.0f;
                 for (auto& pin : progNode->pinsIn)
@@ -2677,6 +3258,13 @@ void ShaderNodeEditor::DrawGui()
                 ImNodes::BeginNodeTitleBar();
                 ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 0.0f));
                 ImGui::Text("Image");
+                if (!imgNode->formatWarning.empty())
+                {
+                    ImGui::SameLine();
+                    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "  " ICON_FK_EXCLAMATION_TRIANGLE);
+                    if (ImGui::IsItemHovered())
+                        ImGui::SetTooltip("%s", imgNode->formatWarning.c_str());
+                }
                 ImGui::PopStyleVar();
                 ImNodes::EndNodeTitleBar();
 
@@ -2700,6 +3288,43 @@ void ShaderNodeEditor::DrawGui()
                 ImNodes::PopColorStyle();
                 ImNodes::PopColorStyle();
             }
+            // Sampler nodes
+            if (node->type == EditorNodeType::SAMPLER)
+            {
+                ImNodes::PushColorStyle(ImNodesCol_TitleBar, IM_COL32(140, 90, 32, 225));
+                ImNodes::PushColorStyle(ImNodesCol_TitleBarHovered, IM_COL32(140, 90, 32, 225));
+                ImNodes::PushColorStyle(ImNodesCol_TitleBarSelected, IM_COL32(140, 90, 32, 225));
+
+                EditorSamplerNode* samplerNode = (EditorSamplerNode*)node;
+                ImNodes::BeginNode(samplerNode->id);
+
+                // Title
+                ImNodes::BeginNodeTitleBar();
+                ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 0.0f));
+                ImGui::Text("Sampler");
+                ImGui::PopStyleVar();
+                ImNodes::EndNodeTitleBar();
+
+                ImGui::Dummy(ImVec2(1.0f, 0.5f));
+                // Inputs
+                ImGui::BeginGroup();
+                for (auto& pin : samplerNode->pinsIn)
+                    InputPin(node, pin);
+                ImGui::EndGroup();
+                ImGui::SameLine();
+                // Outputs
+                ImGui::BeginGroup();
+                for (auto& pin : samplerNode->pinsOut)
+                    OutputPin(node, pin);
+                ImGui::EndGroup();
+                ImGui::Dummy(ImVec2(1.0f, 0.5f));
+
+                ImNodes::EndNode();
+
+                ImNodes::PopColorStyle();
+                ImNodes::PopColorStyle();
+                ImNodes::PopColorStyle();
+            }
             // Ping-pong nodes
             if (node->type == EditorNodeType::PINGPONG)
             {
@@ -2852,6 +3477,8 @@ void ShaderNodeEditor::DrawGui()
                 m_SelectedItemType = SelectedItemType::BUFFER_NODE;
             else if (m_Nodes[id]->type == EditorNodeType::IMAGE)
                 m_SelectedItemType = SelectedItemType::IMAGE_NODE;
+            else if (m_Nodes[id]->type == EditorNodeType::SAMPLER)
+                m_SelectedItemType = SelectedItemType::SAMPLER_NODE;
             else if (m_Nodes[id]->type == EditorNodeType::PINGPONG)
                 m_SelectedItemType = SelectedItemType::PINGPONG_NODE;
             else
@@ -3014,8 +3641,13 @@ void ShaderNodeEditor::DrawGui()
                 }
                 else if (pin->type == EditorPinType::TEXTURE &&
                     !pin->isOutput &&
-                    m_Textures.size() > 0)
+                    (m_Textures.size() > 0 || pin->pNode->type == EditorNodeType::PROGRAM))
                 {
+                    if (pin->pNode->type == EditorNodeType::PROGRAM && ImGui::MenuItem("Sampler"))
+                    {
+                        CreateSamplerNode(m_HangPos);
+                        CreateLink(m_Nodes.back()->pinsOut[0]->id, pin->id);
+                    }
                     for (int i = 0; i < m_Textures.size(); i++)
                     {
                         std::string name = "Texture: " + m_Textures[i]->GetName();
@@ -3035,6 +3667,11 @@ void ShaderNodeEditor::DrawGui()
                         CreateImageNode(m_HangPos);
                         CreateLink(m_Nodes.back()->pinsIn[0]->id, pin->id);
                     }
+                    if (ImGui::MenuItem("Sampler"))
+                    {
+                        CreateSamplerNode(m_HangPos);
+                        CreateLink(m_Nodes.back()->pinsIn[0]->id, pin->id);
+                    }
                 }
                 else if (pin->type == EditorPinType::IMAGE &&
                     pin->pNode->type == EditorNodeType::PROGRAM &&
@@ -3042,7 +3679,10 @@ void ShaderNodeEditor::DrawGui()
                 {
                     if (ImGui::MenuItem("Image"))
                     {
+                        // The image is created in the format the shader declares
                         CreateImageNode(m_HangPos);
+                        auto progNode = (EditorProgramNode*)pin->pNode;
+                        ((EditorImageNode*)m_Nodes.back())->format = progNode->target->GetImageFormat(pin->name);
                         CreateLink(m_Nodes.back()->pinsOut[0]->id, pin->id);
                     }
                     if (ImGui::MenuItem("Ping-Pong"))
@@ -3071,7 +3711,7 @@ void ShaderNodeEditor::DrawGui()
                             CreateLink(m_Nodes.back()->pinsIn[0]->id, pin->id);
                     }
                 }
-                else if (pin->type == EditorPinType::FLOAT && !pin->isOutput)
+                else if (pin->type == EditorPinType::FLOAT && !pin->isOutput && !pin->isSpecConstant)
                 {
                     if (ImGui::MenuItem("Time"))
                     {
@@ -3115,6 +3755,8 @@ void ShaderNodeEditor::DrawGui()
                     CreateBlockNode(m_HangPos);
                 if (ImGui::MenuItem("Image"))
                     CreateImageNode(m_HangPos);
+                if (ImGui::MenuItem("Sampler"))
+                    CreateSamplerNode(m_HangPos);
                 if (ImGui::MenuItem("Ping-Pong"))
                     CreatePingPongNode(m_HangPos);
                 ImGui::Separator();
@@ -3173,9 +3815,9 @@ void ShaderNodeEditor::DrawGui()
                 ImGui::SetCursorPos(ImVec2(ImGui::GetCursorPos().x + 6, ImGui::GetCursorPos().y + 6));
                 if (ImGui::IconButton(ICON_FK_PLUS, "  Add##tex", ImVec4(0.4f, 0.8f, 0.4f, 1.0f), ImVec2(70, 25)))
                 {
-                    const char* filterItems[5] = { "*.jpg", "*.jpeg", "*.png", "*.bmp", "*.tga" };
-                    const char* filterDesc = "Image Files (*.jpg;*.jpeg;*.png;*.bmp;*.tga)";
-                    auto paths_c = tinyfd_openFileDialog("Load Texture", "", 5, filterItems, filterDesc, 1);
+                    const char* filterItems[8] = { "*.jpg", "*.jpeg", "*.png", "*.bmp", "*.tga", "*.hdr", "*.dds", "*.ktx2" };
+                    const char* filterDesc = "Image Files (*.jpg;*.jpeg;*.png;*.bmp;*.tga;*.hdr;*.dds;*.ktx2)";
+                    auto paths_c = tinyfd_openFileDialog("Load Texture", "", 8, filterItems, filterDesc, 1);
                     if (paths_c)
                     {
                         std::stringstream ssPaths(paths_c);
@@ -3183,7 +3825,8 @@ void ShaderNodeEditor::DrawGui()
                         while (std::getline(ssPaths, path, '|'))
                         {
                             Texture* tex = new Texture(PathUtil::UniversalPath(path).c_str());
-                            m_Textures.push_back(tex);
+                            tex->Load(m_Workers, m_TextureUploader);
+                            AddTexture(tex);
                         }
                     }
                 }
@@ -3241,10 +3884,18 @@ void ShaderNodeEditor::DrawGui()
                             ImGui::SetCursorPosX(ImGui::GetCursorPosX() + 10);
                             ImGui::SetCursorPosY(ImGui::GetCursorPosY() - 130);
                             ImGui::Image((void*)m_Textures[i]->GetTexture(), ImVec2(100, 100));
+                            // Textures whose last load failed
+                            std::string errorLog = m_Textures[i]->GetErrorLog();
+                            if (!errorLog.empty() && ImGui::IsItemHovered())
+                                ImGui::SetTooltip("%s", errorLog.c_str());
                             ImGui::Dummy(ImVec2(2, 1));
                             ImGui::SameLine();
                             ImGui::SetNextItemWidth(108);
+                            if (!errorLog.empty())
+                                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
                             ImGui::TextClipped(m_Textures[i]->GetName().c_str());
+                            if (!errorLog.empty())
+                                ImGui::PopStyleColor();
                         }
                         ImGui::EndGroup();
 
@@ -3302,6 +3953,13 @@ void ShaderNodeEditor::DrawGui()
                 std::string name = m_Programs[m_SelectedItemId]->GetName();
                 if (ImGui::InputText("##progName", &name))
                     m_Programs[m_SelectedItemId]->SetName(name.c_str());
+
+                // Separable, stages are shared with other programs through a pipeline
+                ImGui::Text("\t\tSeparable");
+                ImGui::SameLine(160);
+                bool isSeparable = m_Programs[m_SelectedItemId]->IsSeparable();
+                if (ImGui::Checkbox("##progSeparable", &isSeparable))
+                    m_Programs[m_SelectedItemId]->SetSeparable(isSeparable);
             }
 
             // Section 2: Shaders
@@ -3341,7 +3999,7 @@ void ShaderNodeEditor::DrawGui()
             if (isNodeOpened)
             {
                 ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.25f, 0.25f, 0.25f, 0.4f));
-                std::vector<std::string> shaders = m_Programs[m_SelectedItemId]->GetShaderFiles();
+                const std::vector<std::string>& shaders = m_Programs[m_SelectedItemId]->GetShaderFiles();
                 for (int i = 0; i < shaders.size(); i++)
                 {
                     // Name
@@ -3395,6 +4053,30 @@ void ShaderNodeEditor::DrawGui()
                 }
                 ImGui::PopStyleColor();
             }
+
+            // Section 3: Build errors of the last submission, the previous program stays in use
+            std::string errorLog = m_Programs[m_SelectedItemId]->GetErrorLog();
+            if (!errorLog.empty())
+            {
+                ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+                ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 4));
+                ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 0.0f);
+                ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 0.0f);
+                ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.25f, 0.25f, 0.25f, 1.0f));
+                ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.4f, 0.4f, 0.4f, 1.0f));
+                ImGui::PushStyleColor(ImGuiCol_HeaderActive, ImVec4(0.4f, 0.4f, 0.4f, 1.0f));
+                isNodeOpened = ImGui::CollapsingHeader("Errors", ImGuiTreeNodeFlags_SpanAvailWidth);
+                ImGui::PopStyleVar(3);
+                ImGui::PopStyleColor(3);
+
+                if (isNodeOpened)
+                {
+                    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.5f, 0.5f, 1.0f));
+                    ImGui::InputTextMultiline("##progErrors", &errorLog,
+                        ImVec2(ImGui::GetContentRegionAvail().x, 200), ImGuiInputTextFlags_ReadOnly);
+                    ImGui::PopStyleColor();
+                }
+            }
         }
 
         else if (m_SelectedItemType == SelectedItemType::FRAMEBUFFER)
@@ -3455,6 +4137,23 @@ void ShaderNodeEditor::DrawGui()
                         if (iVal > 8) iVal = 8;
                         m_Framebuffers[m_SelectedItemId]->SetNumAttachments(iVal);
                     }
+                    ImGui::PushStyleColor(ImGuiCol_PopupBg, ImVec4(0.13f, 0.13f, 0.13f, 1.0f));
+                    for (int i = 0; i < m_Framebuffers[m_SelectedItemId]->NumAttachments(); i++)
+                    {
+                        std::string label = "\t\tAttachment " + std::to_string(i);
+                        std::string idStr = "##framebufferFormat" + std::to_string(i);
+                        ImGui::Text(label.c_str());
+                        ImGui::SameLine(160);
+                        ImGui::SetNextItemWidth(150);
+                        int format = TextureFormat::IndexOf(m_Framebuffers[m_SelectedItemId]->GetAttachmentFormat(i));
+                        if (ImGui::Combo(idStr.c_str(), &format, TextureFormat::GetName, 0, TextureFormat::Count()))
+                        {
+                            // Plans keep the attachment formats for clearing, and samplers reading them may need nearest filtering
+                            m_Framebuffers[m_SelectedItemId]->SetAttachmentFormat(i, TextureFormat::Get(format).internalFormat);
+                            m_FramePlanDirty = true;
+                        }
+                    }
+                    ImGui::PopStyleColor();
 
                     // Renderbuffer
                     ImGui::Text("\t\tRenderbuffer");
@@ -3494,6 +4193,7 @@ void ShaderNodeEditor::DrawGui()
                 ImGui::PushStyleColor(ImGuiCol_PopupBg, ImVec4(0.13f, 0.13f, 0.13f, 1.0f));
                 if (ImGui::Combo("##progNodeDispatchType", &iVal, items))
                 {
+                    m_FramePlanDirty = true;
                     node->drawMode = GL_POINTS;
                     if (iVal == 0)
                     {
@@ -3626,8 +4326,8 @@ void ShaderNodeEditor::DrawGui()
                 newPin->id = m_Pins.size();
                 m_Pins.push_back(newPin);
                 node->pinsIn.push_back(newPin);
-                node->size += EditorNodeUtil::PinTypeSize(newPin->type);
-                node->pinsOut[0]->size = node->size;
+                m_FramePlanDirty = true;
+                LayoutBlockNode(node);
                 auto links = node->pinsOut[0]->connectedLinks;
                 for (auto& link : links)
                     DeleteLink(link->id);
@@ -3716,7 +4416,6 @@ void ShaderNodeEditor::DrawGui()
 
                         if (newPin)
                         {
-                            node->size -= EditorNodeUtil::PinTypeSize(pinIn->type);
                             newPin->pNode = node;
                             newPin->name = pinIn->name;
                             newPin->id = pinIn->id;
@@ -3724,8 +4423,7 @@ void ShaderNodeEditor::DrawGui()
                             DeletePin(pinIn);
                             m_Pins[id] = newPin;
                             pinIn = newPin;
-                            node->size += EditorNodeUtil::PinTypeSize(newPin->type);
-                            node->pinsOut[0]->size = node->size;
+                            LayoutBlockNode(node);
                             auto links = node->pinsOut[0]->connectedLinks;
                             for (auto& link : links)
                                 DeleteLink(link->id);
@@ -3745,14 +4443,13 @@ void ShaderNodeEditor::DrawGui()
                     idStr = ICON_FK_TRASH "##block_var" + std::to_string(pinIn->id);
                     if (ImGui::SmallButton(idStr.c_str()))
                     {
-                        node->size -= EditorNodeUtil::PinTypeSize(pinIn->type);
-                        node->pinsOut[0]->size = node->size;
                         auto links = node->pinsOut[0]->connectedLinks;
                         for (auto& link : links)
                             DeleteLink(link->id);
                         m_Pins[pinIn->id] = 0;
                         DeletePin(pinIn);
                         node->pinsIn.erase(node->pinsIn.begin() + pinIndex);
+                        LayoutBlockNode(node);
                         pinIndex--;
                         UpdatePins();
                         UpdateLinks();
@@ -3778,12 +4475,30 @@ void ShaderNodeEditor::DrawGui()
 
             if (isNodeOpened)
             {
+                ImGui::Text("\t\tLayout");
+                ImGui::SameLine(160);
+                ImGui::SetNextItemWidth(150);
+                int layout = node->isStd430 ? 1 : 0;
+                ImGui::PushStyleColor(ImGuiCol_PopupBg, ImVec4(0.13f, 0.13f, 0.13f, 1.0f));
+                if (ImGui::Combo("##blockBuffer_Layout", &layout, "std140\0std430\0"))
+                {
+                    node->isStd430 = layout == 1;
+                    LayoutBlockNode(node);
+                    auto links = node->pinsOut[0]->connectedLinks;
+                    for (auto& link : links)
+                        DeleteLink(link->id);
+                    UpdateLinks();
+                    needsUpdate = true;
+                }
+                ImGui::PopStyleColor();
+
                 ImGui::Text("\t\tSize");
                 ImGui::SameLine(160);
                 ImGui::SetNextItemWidth(150);
                 int iVal = node->ssboSize;
                 if (ImGui::InputInt("##blockBuffer_Size", &iVal, 0))
                 {
+                    if (iVal < 1) iVal = 1;
                     node->ssboSize = iVal;
                     needsUpdate = true;
                 }
@@ -3791,12 +4506,8 @@ void ShaderNodeEditor::DrawGui()
 
             if (needsUpdate)
             {
-                glBindBuffer(GL_UNIFORM_BUFFER, node->ubo);
-                glBufferData(GL_UNIFORM_BUFFER, node->size, NULL, GL_DYNAMIC_DRAW);
-                glBindBuffer(GL_UNIFORM_BUFFER, 0);
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER, node->ssbo);
-                glBufferData(GL_SHADER_STORAGE_BUFFER, node->size * node->ssboSize, NULL, GL_DYNAMIC_DRAW);
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+                AllocBlockBuffers(node);
+                node->dirty = true;
             }
         }
 
@@ -3847,15 +4558,126 @@ void ShaderNodeEditor::DrawGui()
 
                     needsUpdate = true;
                 }
+
+                // Format, bound to programs in the format their shader declares
+                ImGui::Text("\t\tFormat");
+                ImGui::SameLine(160);
+                ImGui::SetNextItemWidth(150);
+                int format = TextureFormat::IndexOf(node->format);
+                ImGui::PushStyleColor(ImGuiCol_PopupBg, ImVec4(0.13f, 0.13f, 0.13f, 1.0f));
+                if (ImGui::Combo("##imageFormat", &format, TextureFormat::GetName, 0, TextureFormat::Count()))
+                {
+                    node->format = TextureFormat::Get(format).internalFormat;
+                    needsUpdate = true;
+                }
+                ImGui::PopStyleColor();
             }
 
             if (needsUpdate)
             {
-                glGenTextures(1, &node->texture);
-                glBindTexture(GL_TEXTURE_2D, node->texture);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, node->sizeX, node->sizeY, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-                glBindTexture(GL_TEXTURE_2D, 0);
+                AllocImageNodeTexture(node);
+                m_FramePlanDirty = true;
+            }
+        }
+
+        else if (m_SelectedItemType == SelectedItemType::SAMPLER_NODE)
+        {
+            // Get Selection Id
+            int id;
+            ImNodes::GetSelectedNodes(&id);
+            EditorSamplerNode* node = (EditorSamplerNode*)m_Nodes[id];
+
+            bool needsUpdate = false;
+
+            // title bar
+            ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+            ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 4));
+            ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 0.0f);
+            ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 0.0f);
+            ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.25f, 0.25f, 0.25f, 1.0f));
+            ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.4f, 0.4f, 0.4f, 1.0f));
+            ImGui::PushStyleColor(ImGuiCol_HeaderActive, ImVec4(0.4f, 0.4f, 0.4f, 1.0f));
+            bool isNodeOpened = ImGui::CollapsingHeader("Sampler Node", ImGuiTreeNodeFlags_SpanAvailWidth);
+            ImGui::PopStyleVar(3);
+            ImGui::PopStyleColor(3);
+
+            if (isNodeOpened)
+            {
+                const GLenum minFilters[] = {
+                    GL_NEAREST, GL_LINEAR,
+                    GL_NEAREST_MIPMAP_NEAREST, GL_LINEAR_MIPMAP_NEAREST,
+                    GL_NEAREST_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR
+                };
+                const GLenum wrapModes[] = {
+                    GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_BORDER
+                };
+                const char* wrapItems = "Repeat\0Mirrored Repeat\0Clamp to Edge\0Clamp to Border\0";
+                ImGui::PushStyleColor(ImGuiCol_PopupBg, ImVec4(0.13f, 0.13f, 0.13f, 1.0f));
+
+                // Filtering, fixed to nearest for integer textures
+                EditorPin* samplerIn = node->pinsIn[0];
+                bool isInteger = samplerIn->connectedLinks.size() > 0 &&
+                    TextureFormat::IsInteger(GetTextureFormat(GetConnectedPin(node, samplerIn->connectedLinks[0])));
+                ImGui::BeginDisabled(isInteger);
+                ImGui::Text("\t\tMin Filter");
+                ImGui::SameLine(160);
+                ImGui::SetNextItemWidth(150);
+                int iVal = std::find(minFilters, minFilters + 6, node->minFilter) - minFilters;
+                if (ImGui::Combo("##samplerNodeMinFilter", &iVal,
+                    "Nearest\0Linear\0Nearest, Nearest Mip\0Linear, Nearest Mip\0Nearest, Linear Mip\0Linear, Linear Mip\0"))
+                {
+                    node->minFilter = minFilters[iVal];
+                    needsUpdate = true;
+                }
+                ImGui::Text("\t\tMag Filter");
+                ImGui::SameLine(160);
+                ImGui::SetNextItemWidth(150);
+                iVal = node->magFilter == GL_NEAREST ? 0 : 1;
+                if (ImGui::Combo("##samplerNodeMagFilter", &iVal, "Nearest\0Linear\0"))
+                {
+                    node->magFilter = iVal == 0 ? GL_NEAREST : GL_LINEAR;
+                    needsUpdate = true;
+                }
+                ImGui::EndDisabled();
+
+                // Wrapping
+                ImGui::Text("\t\tWrap S");
+                ImGui::SameLine(160);
+                ImGui::SetNextItemWidth(150);
+                iVal = std::find(wrapModes, wrapModes + 4, node->wrapS) - wrapModes;
+                if (ImGui::Combo("##samplerNodeWrapS", &iVal, wrapItems))
+                {
+                    node->wrapS = wrapModes[iVal];
+                    needsUpdate = true;
+                }
+                ImGui::Text("\t\tWrap T");
+                ImGui::SameLine(160);
+                ImGui::SetNextItemWidth(150);
+                iVal = std::find(wrapModes, wrapModes + 4, node->wrapT) - wrapModes;
+                if (ImGui::Combo("##samplerNodeWrapT", &iVal, wrapItems))
+                {
+                    node->wrapT = wrapModes[iVal];
+                    needsUpdate = true;
+                }
+                ImGui::PopStyleColor();
+
+                // Anisotropy
+                if (GLEW_ARB_texture_filter_anisotropic || GLEW_EXT_texture_filter_anisotropic)
+                {
+                    float maxAnisotropy = 1.0f;
+                    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+                    ImGui::Text("\t\tAnisotropy");
+                    ImGui::SameLine(160);
+                    ImGui::SetNextItemWidth(150);
+                    ImGui::BeginDisabled(isInteger);
+                    if (ImGui::SliderFloat("##samplerNodeAnisotropy", &node->anisotropy, 1.0f, maxAnisotropy, "%.0fx"))
+                        needsUpdate = true;
+                    ImGui::EndDisabled();
+                }
             }
+
+            if (needsUpdate)
+                UpdateSamplerNode(node);
         }
 
         else if (m_SelectedItemType == SelectedItemType::PINGPONG_NODE)
@@ -3894,6 +4716,79 @@ void ShaderNodeEditor::DrawGui()
             ImGui::PopStyleColor();
         }
 
+        else if (m_SelectedItemType == SelectedItemType::NONE)
+        {
+            // title bar
+            ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+            ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 4));
+            ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 0.0f);
+            ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 0.0f);
+            ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.25f, 0.25f, 0.25f, 1.0f));
+            ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.4f, 0.4f, 0.4f, 1.0f));
+            ImGui::PushStyleColor(ImGuiCol_HeaderActive, ImVec4(0.4f, 0.4f, 0.4f, 1.0f));
+            bool isNodeOpened = ImGui::CollapsingHeader("Statistics", ImGuiTreeNodeFlags_SpanAvailWidth);
+            ImGui::PopStyleVar(3);
+            ImGui::PopStyleColor(3);
+
+            if (isNodeOpened)
+            {
+                ImGui::Text("\t\tGL Binds Issued");
+                ImGui::SameLine(160);
+                ImGui::Text("%d", m_GLState.NumIssued());
+                ImGui::Text("\t\tGL Binds Elided");
+                ImGui::SameLine(160);
+                ImGui::Text("%d", m_GLState.NumElided());
+                ImGui::Text("\t\tUniform Uploads");
+                ImGui::SameLine(160);
+                ImGui::Text("%d", m_NumUniformUploads);
+                ImGui::Text("\t\tBlock Uploads");
+                ImGui::SameLine(160);
+                ImGui::Text("%d", m_NumBlockUploads);
+                ImGui::Text("\t\tMemory Barriers");
+                ImGui::SameLine(160);
+                ImGui::Text("%d", m_Barriers.NumBarriers());
+                ImGui::Text("\t\tStage Programs");
+                ImGui::SameLine(160);
+                ImGui::Text("%d", StageCache::NumStages());
+                ImGui::Text("\t\tTexture Uploads");
+                ImGui::SameLine(160);
+                ImGui::Text("%d", m_TextureUploader.NumUploads());
+                ImGui::Text("\t\tDecoded Images");
+                ImGui::SameLine(160);
+                ImGui::Text("%.1f MB", ImageCache::GetCachedBytes() / (1024.0f * 1024.0f));
+            }
+
+            ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+            ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 4));
+            ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 0.0f);
+            ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 0.0f);
+            ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.25f, 0.25f, 0.25f, 1.0f));
+            ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(0.4f, 0.4f, 0.4f, 1.0f));
+            ImGui::PushStyleColor(ImGuiCol_HeaderActive, ImVec4(0.4f, 0.4f, 0.4f, 1.0f));
+            isNodeOpened = ImGui::CollapsingHeader("GPU Time", ImGuiTreeNodeFlags_SpanAvailWidth);
+            ImGui::PopStyleVar(3);
+            ImGui::PopStyleColor(3);
+
+            if (isNodeOpened)
+            {
+                // Per-command breakdown of the last frame read back
+                float total = 0.0f;
+                for (auto& time : m_GpuFrameTimes)
+                {
+                    if (time.first >= m_Nodes.size() || m_Nodes[time.first]->type != EditorNodeType::PROGRAM)
+                        continue;
+                    EditorProgramNode* progNode = (EditorProgramNode*)m_Nodes[time.first];
+                    ImGui::Text("\t\t%s", progNode->target->GetName().c_str());
+                    ImGui::SameLine(160);
+                    ImGui::Text("%.3f ms", time.second);
+                    total += time.second;
+                }
+                ImGui::Text("\t\tTotal");
+                ImGui::SameLine(160);
+                ImGui::Text("%.3f ms", total);
+            }
+        }
+
         ImGui::EndChild();
     }
 
@@ -6,6 +6,14 @@
 #include "imnodes.h"
 
 #include "editornode.h"
+#include "frameplan.h"
+#include "glstate.h"
+#include "barriertracker.h"
+#include "gputimer.h"
+#include "ringbuffer.h"
+#include "threadpool.h"
+#include "filewatcher.h"
+#include "textureuploader.h"
 
 class ShaderNodeEditor
 {
@@ -29,10 +37,33 @@ private:
 
 private:
 	bool m_OnInit;
+	// A restart is waiting for its programs to finish compiling
+	bool m_IsWaitingForPrograms;
 	bool m_IsPlaying;
 
 	bool m_PingPongSwap;
 
+	std::vector<EditorFrameCommand> m_InitPlan;
+	std::vector<EditorFrameCommand> m_FramePlan;
+	bool m_FramePlanDirty;
+
+	// Reads shader sources and decodes images off the GL thread
+	ThreadPool m_Workers;
+	TextureUploader m_TextureUploader;
+	FileWatcher m_FileWatcher;
+
+	GLState m_GLState;
+	BarrierTracker m_Barriers;
+	GpuTimer m_GpuTimer;
+	// Node id and GPU time of each command in the last resolved frame
+	std::vector<std::pair<int, float>> m_GpuFrameTimes;
+	// Read back into this one first, then swapped with the times above
+	std::vector<std::pair<int, float>> m_GpuResolvedTimes;
+	RingBuffer m_UniformRing;
+	int m_NumUniformUploads;
+	int m_NumBlockUploads;
+	GLuint m_EmptyVertexArray;
+
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_StartTime;
 
 public:
@@ -62,6 +93,7 @@ private:
 		PROGRAM_NODE,
 		BUFFER_NODE,
 		IMAGE_NODE,
+		SAMPLER_NODE,
 		PINGPONG_NODE
 	};
 	SelectedItemType m_SelectedItemType;
@@ -85,16 +117,22 @@ private:
 	void CreateLink(int startPinId, int endPinId);
 
 private:
-	EditorPin* AllocPin(ShaderVar* var);
+	EditorPin* AllocPin(const ShaderVar* var);
 
+	void AllocProgramPins(EditorProgramNode* node, std::vector<EditorPin*>& pinsIn, std::vector<EditorPin*>& pinsOut);
 	EditorProgramNode* CreateProgramNodePtr(int progId, const ImVec2& pos);
 	void CreateProgramNode(int progId, const ImVec2& pos);
-	void UpdateProgramNode(int nodeId, int progId);
+	bool UpdateProgramNode(int nodeId, int progId);
 	void SetProgramNodeFramebuffer(EditorProgramNode* node, int framebufferId);
 
 	void CreateBlockNode(const ImVec2& pos, int pinId = -1);
+	void LayoutBlockNode(EditorBlockNode* node);
+	void AllocBlockBuffers(EditorBlockNode* node);
 	void CreateTextureNode(int textureId, const ImVec2& pos);
 	void CreateImageNode(const ImVec2& pos);
+	void AllocImageNodeTexture(EditorImageNode* node);
+	void CreateSamplerNode(const ImVec2& pos);
+	void UpdateSamplerNode(EditorSamplerNode* node);
 
 	void CreatePingPongNode(const ImVec2& pos,
 		EditorPingPongNodeType type = EditorPingPongNodeType::BUFFER);
@@ -107,15 +145,33 @@ private:
 	ImNodesPinShape BeginPin(EditorPin* pin, float alpha);
 	void EndPin();
 	void InputPin(EditorNode* node, EditorPin* pin);
+	void MarkPinDirty(EditorPin* pin);
 	void OutputPin(EditorNode* node, EditorPin* pin);
 
 private:
 	EditorPin* GetConnectedPin(EditorNode* node, EditorLink* link);
 	// The target block/image node may go through multiple program/ping-pong nodes
 	// before it is linked to the input pin
-	void GetInputTargetNode(EditorNode*& connectedNode, EditorPinType type, int index);
-
-	void ExecuteProgramNode(EditorProgramNode* progNode);
+	void GetInputTargetNode(EditorNode*& connectedNode, EditorPinType type, int index, bool swap);
+	GLuint GetImageNodeTexture(EditorImageNode* imgNode);
+	// Output pin of the texture behind a sampler node chain, 0 if it has no input
+	EditorPin* GetTextureSource(EditorPin* pin);
+	// Internal format of the texture behind an output pin, through sampler nodes
+	GLenum GetTextureFormat(EditorPin* pin);
+	// Only file textures have mip chains, attachments and image nodes have one level
+	bool HasMipmaps(EditorPin* pin);
+	EditorFrameValueSource GetValueSource(EditorNode* node, EditorPin* pin);
+
+	void CompileProgramNode(EditorProgramNode* progNode, EditorFrameCommand& cmd);
+	void CheckImageFormat(EditorImageNode* imgNode, EditorProgramNode* progNode, EditorPin* pin);
+	void CompileFlow(EditorEventNode* eventNode, std::vector<EditorFrameCommand>& plan);
+	void CompileFramePlans();
+	void PackBlockNode(const EditorFrameBlock& block, int swap, float time, const float* mouse);
+	void ExecuteFrameCommand(const EditorFrameCommand& cmd);
+	void ExecutePlan(const std::vector<EditorFrameCommand>& plan);
+	void ResetRuntimeState();
+	void RecordGpuTime(EditorProgramNode* node, float time);
+	void UpdateWatchedFiles();
 
 public:
 	void Initialize();
@@ -31,6 +31,7 @@ enum class EditorNodeType
 	FRAMEBUFFER,
 	TEXTURE,
 	IMAGE,
+	SAMPLER,
 	BLOCK,
 	PINGPONG,
 	TIME,
@@ -65,6 +66,8 @@ struct EditorNode
 	std::vector<EditorPin*> pinsIn;
 	std::vector<EditorPin*> pinsOut;
 	ImVec2 nodePos;
+
+	virtual ~EditorNode() {}
 };
 
 struct EditorEventNode : public EditorNode
@@ -72,6 +75,16 @@ struct EditorEventNode : public EditorNode
 	EditorEventNodeType eventNodeType = EditorEventNodeType::INIT;
 };
 
+struct EditorTimingStats
+{
+	std::vector<float> samples; // Rolling window of GPU times in milliseconds
+	std::vector<float> sorted; // The same samples in ascending order
+	double sum = 0.0;
+	int next = 0;
+	float average = 0.0f;
+	float p95 = 0.0f;
+};
+
 struct EditorProgramNode : public EditorNode
 {
 	Program* target = 0;
@@ -83,6 +96,8 @@ struct EditorProgramNode : public EditorNode
 	EditorProgramDispatchType dispatchType = EditorProgramDispatchType::ARRAY;
 	GLenum drawMode = GL_POINTS;
 	int dispatchSize[3]{};
+
+	EditorTimingStats gpuTime;
 };
 
 struct EditorTextureNode : public EditorNode
@@ -94,7 +109,10 @@ struct EditorImageNode : public EditorNode
 {
 	int sizeX = 0;
 	int sizeY = 0;
+	GLenum format = GL_RGBA8;
 	GLuint texture = -1;
+	// Set by the frame plan when a program declares an image of another texel size
+	std::string formatWarning;
 
 	~EditorImageNode()
 	{
@@ -103,10 +121,32 @@ struct EditorImageNode : public EditorNode
 	}
 };
 
+// Sits between a texture and the program input sampling it, the sampler
+// object replaces the texture's own filtering and wrapping
+struct EditorSamplerNode : public EditorNode
+{
+	GLenum minFilter = GL_LINEAR;
+	GLenum magFilter = GL_LINEAR;
+	GLenum wrapS = GL_REPEAT;
+	GLenum wrapT = GL_REPEAT;
+	float anisotropy = 1.0f;
+	GLuint sampler = -1;
+
+	~EditorSamplerNode()
+	{
+		if (sampler != -1)
+			glDeleteSamplers(1, &sampler);
+	}
+};
+
 struct EditorBlockNode : public EditorNode
 {
 	int size = 0;
-	GLuint ubo = -1;
+	int stride = 0; // Stride of a trailing unsized array, 0 if the block has none
+	bool isStd430 = false; // Layout used when members are edited by hand
+	std::vector<GLubyte> data; // CPU staging image laid out like the block
+	bool dirty = true; // At least one member changed since the last upload
+	GLuint ubo = -1; // Resident copy for blocks without per-frame members
 	GLuint ssbo = -1;
 	int ssboSize = 1;
 
@@ -139,6 +179,9 @@ struct EditorPin
 	int size = 1;
 	bool isOutput = false;
 	std::string name = "";
+	int offset = -1; // Byte offset of a block member in its block's layout
+	bool dirty = true; // Value changed since it was last uploaded
+	bool isSpecConstant = false; // Specializes the program's SPIR-V stages instead of setting a uniform
 	EditorNode* pNode = 0;
 	std::vector<EditorLink*> connectedLinks;
 };
@@ -224,6 +267,8 @@ namespace EditorNodeUtil
 		case GL_SAMPLER_2D:
 			return EditorPinType::TEXTURE;
 		case GL_IMAGE_2D:
+		case GL_INT_IMAGE_2D:
+		case GL_UNSIGNED_INT_IMAGE_2D:
 			return EditorPinType::IMAGE;
 
 		default:
@@ -256,6 +301,34 @@ namespace EditorNodeUtil
 		}
 	}
 
+	// std140 base alignment, std430 agrees for scalars and vectors
+	inline int PinTypeAlignment(EditorPinType type)
+	{
+		switch (type)
+		{
+		case EditorPinType::FLOAT:
+		case EditorPinType::INT:
+			return 4;
+		case EditorPinType::FLOAT2:
+		case EditorPinType::INT2:
+			return 8;
+		case EditorPinType::FLOAT3:
+		case EditorPinType::FLOAT4:
+		case EditorPinType::INT3:
+		case EditorPinType::INT4:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	inline int BlockStorageSize(EditorBlockNode* node)
+	{
+		if (node->stride > 0)
+			return node->size + node->stride * (node->ssboSize - 1);
+		return node->size * node->ssboSize;
+	}
+
 	inline int GLDrawModeToIndex(GLenum drawMode)
 	{
 		switch (drawMode)
@@ -0,0 +1,127 @@
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "pathutil.h"
+#include "filewatcher.h"
+
+FileWatcher::FileWatcher()
+#if defined(__linux__)
+	: m_Fd(-1)
+#endif
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	Destroy();
+}
+
+void FileWatcher::SetFiles(const std::vector<std::string>& files)
+{
+	std::vector<std::string> cleanFiles;
+	for (auto& file : files)
+		cleanFiles.push_back(PathUtil::CleanPath(file));
+	std::sort(cleanFiles.begin(), cleanFiles.end());
+	cleanFiles.erase(std::unique(cleanFiles.begin(), cleanFiles.end()), cleanFiles.end());
+	if (cleanFiles == m_Files)
+		return;
+	m_Files = cleanFiles;
+
+#if defined(__linux__)
+	if (m_Fd == -1)
+		m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_Fd == -1)
+		return;
+
+	std::vector<std::string> dirs;
+	for (auto& file : m_Files)
+		dirs.push_back(PathUtil::CleanPath(PathUtil::DirectoryOf(file)));
+	std::sort(dirs.begin(), dirs.end());
+	dirs.erase(std::unique(dirs.begin(), dirs.end()), dirs.end());
+
+	// Drop directories no file lives in anymore, then watch the new ones
+	for (auto it = m_Dirs.begin(); it != m_Dirs.end();)
+	{
+		if (!std::binary_search(dirs.begin(), dirs.end(), it->second))
+		{
+			inotify_rm_watch(m_Fd, it->first);
+			it = m_Dirs.erase(it);
+		}
+		else
+			it++;
+	}
+	for (auto& dir : dirs)
+	{
+		int wd = inotify_add_watch(m_Fd, dir.empty() ? "." : dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wd != -1)
+			m_Dirs[wd] = dir;
+	}
+#else
+	m_Times.assign(m_Files.size(), 0);
+	for (int i = 0; i < m_Files.size(); i++)
+		PathUtil::GetModifiedTime(m_Files[i], m_Times[i]);
+	m_LastCheck = std::chrono::steady_clock::now();
+#endif
+}
+
+void FileWatcher::Poll(std::vector<std::string>& changed)
+{
+#if defined(__linux__)
+	if (m_Fd == -1)
+		return;
+
+	alignas(inotify_event) char buffer[4096];
+	while (true)
+	{
+		ssize_t length = read(m_Fd, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+		for (char* ptr = buffer; ptr < buffer + length;)
+		{
+			const inotify_event* event = (const inotify_event*)ptr;
+			ptr += sizeof(inotify_event) + event->len;
+
+			auto dir = m_Dirs.find(event->wd);
+			if (dir == m_Dirs.end() || event->len == 0)
+				continue;
+			std::string path = dir->second.empty() ? event->name : dir->second + "/" + event->name;
+			path = PathUtil::CleanPath(path);
+			if (std::binary_search(m_Files.begin(), m_Files.end(), path) &&
+				std::find(changed.begin(), changed.end(), path) == changed.end())
+				changed.push_back(path);
+		}
+	}
+#else
+	auto now = std::chrono::steady_clock::now();
+	if (now - m_LastCheck < std::chrono::milliseconds(500))
+		return;
+	m_LastCheck = now;
+
+	for (int i = 0; i < m_Files.size(); i++)
+	{
+		time_t time = 0;
+		if (PathUtil::GetModifiedTime(m_Files[i], time) && time != m_Times[i])
+		{
+			m_Times[i] = time;
+			changed.push_back(m_Files[i]);
+		}
+	}
+#endif
+}
+
+void FileWatcher::Destroy()
+{
+#if defined(__linux__)
+	if (m_Fd != -1)
+		close(m_Fd);
+	m_Fd = -1;
+	m_Dirs.clear();
+#else
+	m_Times.clear();
+#endif
+	m_Files.clear();
+}
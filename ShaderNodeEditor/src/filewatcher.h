@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <ctime>
+
+// Reports files changed on disk. On Linux the directories holding the files
+// are watched with inotify, so editors that save by renaming a temporary file
+// are caught too. Elsewhere the modification times are polled a few times a second
+class FileWatcher
+{
+private:
+	std::vector<std::string> m_Files;
+#if defined(__linux__)
+	int m_Fd;
+	// Watch descriptor to watched directory
+	std::unordered_map<int, std::string> m_Dirs;
+#else
+	std::vector<time_t> m_Times;
+	std::chrono::steady_clock::time_point m_LastCheck;
+#endif
+
+public:
+	FileWatcher();
+	~FileWatcher();
+
+public:
+	// Replaces the set of watched files
+	void SetFiles(const std::vector<std::string>& files);
+	// Appends the files changed since the last call
+	void Poll(std::vector<std::string>& changed);
+	void Destroy();
+};
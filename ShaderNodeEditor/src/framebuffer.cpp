@@ -1,5 +1,7 @@
 #include "framebuffer.h"
 
+#include "textureformat.h"
+
 Framebuffer::Framebuffer() :
 	m_Name(""),
 	m_Framebuffer(-1),
@@ -61,6 +63,7 @@ GLuint Framebuffer::GetTexture(int index)
 void Framebuffer::SetNumAttachments(int n)
 {
 	m_NumAttachments = n;
+	m_Formats.resize(n, GL_RGBA8);
 	m_NeedsInit = true;
 }
 
@@ -75,6 +78,19 @@ void Framebuffer::SetRenderbuffer(bool b)
 	m_NeedsInit = true;
 }
 
+void Framebuffer::SetAttachmentFormat(int index, GLenum format)
+{
+	m_Formats[index] = format;
+	m_NeedsInit = true;
+}
+
+GLenum Framebuffer::GetAttachmentFormat(int index)
+{
+	if (index < m_Formats.size())
+		return m_Formats[index];
+	return GL_RGBA8;
+}
+
 bool Framebuffer::HasRenderbuffer()
 {
 	return m_HasRenderBuffer;
@@ -111,35 +127,35 @@ void Framebuffer::Initialize()
 		glDeleteRenderbuffers(1, &m_Renderbuffer);
 
 	// Create new framebuffer
-	glGenFramebuffers(1, &m_Framebuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	glCreateFramebuffers(1, &m_Framebuffer);
 
 	// Create attachments
+	std::vector<GLenum> drawBuffers;
 	for (int i = 0; i < m_NumAttachments; i++)
 	{
 		GLuint texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, texture, 0);
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		if (m_Width > 0 && m_Height > 0)
+			glTextureStorage2D(texture, 1, GetAttachmentFormat(i), m_Width, m_Height);
+		// Integer attachments are incomplete with linear filtering
+		GLenum filter = TextureFormat::FilterFor(GetAttachmentFormat(i));
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, filter);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, filter);
+		glNamedFramebufferTexture(m_Framebuffer, GL_COLOR_ATTACHMENT0 + i, texture, 0);
 		m_Textures.push_back(texture);
+		drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
 	}
+	// Draw buffers are framebuffer state, so they are set once here
+	glNamedFramebufferDrawBuffers(m_Framebuffer, drawBuffers.size(), drawBuffers.data());
 
 	// Create renderbuffer
 	if (m_HasRenderBuffer)
 	{
-		glGenRenderbuffers(1, &m_Renderbuffer);
-		glBindRenderbuffer(GL_RENDERBUFFER, m_Renderbuffer);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_Width, m_Height);
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_Renderbuffer);
-		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glCreateRenderbuffers(1, &m_Renderbuffer);
+		glNamedRenderbufferStorage(m_Renderbuffer, GL_DEPTH24_STENCIL8, m_Width, m_Height);
+		glNamedFramebufferRenderbuffer(m_Framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_Renderbuffer);
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
 	m_NeedsInit = false;
 }
 
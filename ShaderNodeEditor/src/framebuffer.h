@@ -19,6 +19,8 @@ private:
 	bool m_NeedsInit;
 
 	std::vector<GLuint> m_Textures;
+	// Internal format of each color attachment
+	std::vector<GLenum> m_Formats;
 	GLuint m_Renderbuffer;
 
 public:
@@ -34,6 +36,8 @@ public:
 	GLuint GetTexture(int index);
 	void SetNumAttachments(int n);
 	int NumAttachments();
+	void SetAttachmentFormat(int index, GLenum format);
+	GLenum GetAttachmentFormat(int index);
 	void SetRenderbuffer(bool b);
 	bool HasRenderbuffer();
 	void SetSize(int width, int height);
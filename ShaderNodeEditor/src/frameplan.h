@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "editornode.h"
+
+// A flow (On Init / On Frame) is compiled into a flat list of commands whose
+// GL handles, locations and bindings are resolved when the graph changes,
+// so replaying it every frame never has to walk the node graph
+
+enum class EditorFrameValueSource
+{
+	PIN,
+	TIME,
+	MOUSE_POS
+};
+
+// Uniforms are set in every program of the command that declares them,
+// which is one per stage for separable programs
+struct EditorFrameUniform
+{
+	EditorPin* pin = 0;
+	EditorFrameValueSource source = EditorFrameValueSource::PIN;
+	std::vector<ProgramLocation> locs;
+};
+
+struct EditorFrameTexture
+{
+	GLuint texture = -1;
+	GLuint sampler = 0; // 0 samples with the texture's own parameters
+	int unit = 0;
+	std::vector<ProgramLocation> locs;
+};
+
+// Inputs going through ping-pong nodes are resolved for both swap states,
+// index 1 is used when the ping-pong buffers are swapped
+struct EditorFrameImage
+{
+	GLuint texture[2]{ (GLuint)-1, (GLuint)-1 };
+	int unit = 0;
+	GLenum format = GL_RGBA8; // From the shader's layout qualifier
+	std::vector<ProgramLocation> locs;
+};
+
+// Blocks with a Time or Mouse Position member change every frame and are
+// streamed through the uniform ring, the others are uploaded only when dirty
+struct EditorFrameBlock
+{
+	EditorBlockPinType blockPinType = EditorBlockPinType::UNIFROM_BLOCK;
+	EditorBlockNode* target[2]{};
+	std::vector<EditorFrameUniform> members[2];
+	bool isDynamic[2]{};
+	// Block index in each program declaring the block
+	std::vector<ProgramLocation> locations;
+	GLuint binding = 0;
+};
+
+struct EditorFrameCommand
+{
+	EditorProgramNode* node = 0;
+	GLuint program = -1;
+	GLuint pipeline = -1;
+	// Programs holding the uniforms, the stages of the pipeline if there is one
+	std::vector<GLuint> programs;
+	// Another command uses one of the same programs, so its uniforms can't be assumed unchanged
+	bool isProgramShared = false;
+
+	GLuint framebuffer = 0;
+	int viewport[2]{};
+	// Internal format of each color attachment, clears depend on its class
+	std::vector<GLenum> attachmentFormats;
+
+	std::vector<EditorFrameUniform> uniforms;
+	std::vector<EditorFrameTexture> textures;
+	std::vector<EditorFrameImage> images;
+	std::vector<EditorFrameBlock> blocks;
+};
@@ -0,0 +1,150 @@
+#include <algorithm>
+
+#include "glstate.h"
+
+GLState::GLState() :
+	m_NumIssued(0),
+	m_NumElided(0)
+{
+	Invalidate();
+}
+
+GLState::~GLState()
+{
+}
+
+void GLState::Invalidate()
+{
+	m_Program = -1;
+	m_Pipeline = -1;
+	m_Framebuffer = -1;
+	m_Viewport[0] = m_Viewport[1] = m_Viewport[2] = m_Viewport[3] = -1;
+	// Runs every frame, the shadows are reset to unknown in place and keep their capacity
+	std::fill(m_Textures.begin(), m_Textures.end(), (GLuint)-1);
+	std::fill(m_Samplers.begin(), m_Samplers.end(), (GLuint)-1);
+	std::fill(m_UniformBuffers.begin(), m_UniformBuffers.end(), BufferBinding{ (GLuint)-1, 0, 0 });
+	std::fill(m_StorageBuffers.begin(), m_StorageBuffers.end(), BufferBinding{ (GLuint)-1, 0, 0 });
+	std::fill(m_Images.begin(), m_Images.end(), ImageBinding{ (GLuint)-1, 0, GL_FALSE, 0, GL_NONE, GL_NONE });
+}
+
+void GLState::ResetStats()
+{
+	m_NumIssued = 0;
+	m_NumElided = 0;
+}
+
+int GLState::NumIssued()
+{
+	return m_NumIssued;
+}
+
+int GLState::NumElided()
+{
+	return m_NumElided;
+}
+
+bool GLState::Elide(bool isRedundant)
+{
+	if (isRedundant)
+		m_NumElided++;
+	else
+		m_NumIssued++;
+	return isRedundant;
+}
+
+std::vector<GLState::BufferBinding>& GLState::IndexedBuffers(GLenum target)
+{
+	if (target == GL_SHADER_STORAGE_BUFFER)
+		return m_StorageBuffers;
+	return m_UniformBuffers;
+}
+
+void GLState::UseProgram(GLuint program)
+{
+	if (Elide(m_Program == program))
+		return;
+	glUseProgram(program);
+	m_Program = program;
+}
+
+void GLState::BindProgramPipeline(GLuint pipeline)
+{
+	if (Elide(m_Pipeline == pipeline))
+		return;
+	glBindProgramPipeline(pipeline);
+	m_Pipeline = pipeline;
+}
+
+void GLState::BindFramebuffer(GLuint framebuffer)
+{
+	if (Elide(m_Framebuffer == framebuffer))
+		return;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	m_Framebuffer = framebuffer;
+}
+
+void GLState::Viewport(int x, int y, int width, int height)
+{
+	if (Elide(m_Viewport[0] == x && m_Viewport[1] == y &&
+		m_Viewport[2] == width && m_Viewport[3] == height))
+		return;
+	glViewport(x, y, width, height);
+	m_Viewport[0] = x;
+	m_Viewport[1] = y;
+	m_Viewport[2] = width;
+	m_Viewport[3] = height;
+}
+
+void GLState::BindTexture(int unit, GLuint texture)
+{
+	if (unit >= m_Textures.size())
+		m_Textures.resize(unit + 1, -1);
+	if (Elide(m_Textures[unit] == texture))
+		return;
+	glBindTextureUnit(unit, texture);
+	m_Textures[unit] = texture;
+}
+
+void GLState::BindSampler(int unit, GLuint sampler)
+{
+	if (unit >= m_Samplers.size())
+		m_Samplers.resize(unit + 1, -1);
+	if (Elide(m_Samplers[unit] == sampler))
+		return;
+	glBindSampler(unit, sampler);
+	m_Samplers[unit] = sampler;
+}
+
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	BindBufferRange(target, index, buffer, 0, 0);
+}
+
+void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	auto& bindings = IndexedBuffers(target);
+	if (index >= bindings.size())
+		bindings.resize(index + 1, BufferBinding{ (GLuint)-1, 0, 0 });
+	BufferBinding& binding = bindings[index];
+	if (Elide(binding.buffer == buffer && binding.offset == offset && binding.size == size))
+		return;
+	// A size of 0 stands for the whole buffer
+	if (size == 0)
+		glBindBufferBase(target, index, buffer);
+	else
+		glBindBufferRange(target, index, buffer, offset, size);
+	binding = BufferBinding{ buffer, offset, size };
+}
+
+void GLState::BindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
+	GLenum access, GLenum format)
+{
+	if (unit >= m_Images.size())
+		m_Images.resize(unit + 1, ImageBinding{ (GLuint)-1, 0, GL_FALSE, 0, GL_NONE, GL_NONE });
+	ImageBinding& image = m_Images[unit];
+	if (Elide(image.texture == texture && image.level == level && image.layered == layered &&
+		image.layer == layer && image.access == access && image.format == format))
+		return;
+	glBindImageTexture(unit, texture, level, layered, layer, access, format);
+	image = ImageBinding{ texture, level, layered, layer, access, format };
+}
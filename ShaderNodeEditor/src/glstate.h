@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+// Shadows the GL bindings touched while executing program nodes, so binds
+// that would not change anything are skipped
+class GLState
+{
+private:
+	struct BufferBinding
+	{
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	struct ImageBinding
+	{
+		GLuint texture;
+		GLint level;
+		GLboolean layered;
+		GLint layer;
+		GLenum access;
+		GLenum format;
+	};
+
+	GLuint m_Program;
+	GLuint m_Pipeline;
+	GLuint m_Framebuffer;
+	int m_Viewport[4];
+	std::vector<GLuint> m_Textures;
+	std::vector<GLuint> m_Samplers;
+	std::vector<BufferBinding> m_UniformBuffers;
+	std::vector<BufferBinding> m_StorageBuffers;
+	std::vector<ImageBinding> m_Images;
+
+	int m_NumIssued;
+	int m_NumElided;
+
+public:
+	GLState();
+	~GLState();
+
+public:
+	void Invalidate();
+	void ResetStats();
+	int NumIssued();
+	int NumElided();
+
+public:
+	void UseProgram(GLuint program);
+	void BindProgramPipeline(GLuint pipeline);
+	void BindFramebuffer(GLuint framebuffer);
+	void Viewport(int x, int y, int width, int height);
+	void BindTexture(int unit, GLuint texture);
+	void BindSampler(int unit, GLuint sampler);
+	void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void BindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
+		GLenum access, GLenum format);
+
+private:
+	bool Elide(bool isRedundant);
+	std::vector<BufferBinding>& IndexedBuffers(GLenum target);
+};
@@ -0,0 +1,84 @@
+#include "gputimer.h"
+
+GpuTimer::GpuTimer(int numFrames) :
+	m_Frames(numFrames),
+	m_Frame(0)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+	Destroy();
+}
+
+bool GpuTimer::BeginFrame(std::vector<std::pair<int, float>>& times)
+{
+	Frame& frame = m_Frames[m_Frame];
+	bool isResolved = false;
+	times.clear();
+	if (frame.isPending && frame.sections.size() > 0)
+	{
+		GLint isAvailable = GL_FALSE;
+		glGetQueryObjectiv(frame.queries[frame.sections.size() * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (isAvailable)
+		{
+			for (int i = 0; i < frame.sections.size(); i++)
+			{
+				GLuint64 begin = 0, end = 0;
+				glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+				glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+				times.push_back({ frame.sections[i], (end - begin) * 1e-6f });
+			}
+			isResolved = true;
+		}
+	}
+	frame.isPending = false;
+	frame.sections.clear();
+	return isResolved;
+}
+
+void GpuTimer::BeginSection(int id)
+{
+	Frame& frame = m_Frames[m_Frame];
+	int index = frame.sections.size() * 2;
+	if (index + 2 > frame.queries.size())
+	{
+		frame.queries.resize(index + 2);
+		glCreateQueries(GL_TIMESTAMP, 2, &frame.queries[index]);
+	}
+	frame.sections.push_back(id);
+	glQueryCounter(frame.queries[index], GL_TIMESTAMP);
+}
+
+void GpuTimer::EndSection()
+{
+	Frame& frame = m_Frames[m_Frame];
+	glQueryCounter(frame.queries[frame.sections.size() * 2 - 1], GL_TIMESTAMP);
+}
+
+void GpuTimer::EndFrame()
+{
+	m_Frames[m_Frame].isPending = true;
+	m_Frame = (m_Frame + 1) % m_Frames.size();
+}
+
+void GpuTimer::Discard()
+{
+	for (auto& frame : m_Frames)
+	{
+		frame.isPending = false;
+		frame.sections.clear();
+	}
+}
+
+void GpuTimer::Destroy()
+{
+	for (auto& frame : m_Frames)
+	{
+		if (frame.queries.size() > 0)
+			glDeleteQueries(frame.queries.size(), frame.queries.data());
+		std::vector<GLuint>().swap(frame.queries);
+		frame.sections.clear();
+		frame.isPending = false;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include <GL/glew.h>
+
+// Brackets sections of a frame with GL_TIMESTAMP queries. Results are read
+// back a few frames later, when the query ring comes around to that frame
+// again, and dropped rather than waited on if the GPU is not done yet
+class GpuTimer
+{
+private:
+	struct Frame
+	{
+		std::vector<GLuint> queries;
+		std::vector<int> sections;
+		bool isPending = false;
+	};
+
+	std::vector<Frame> m_Frames;
+	int m_Frame;
+
+public:
+	GpuTimer(int numFrames = 4);
+	~GpuTimer();
+
+public:
+	// Returns the times in milliseconds of the frame recorded in this slot before
+	bool BeginFrame(std::vector<std::pair<int, float>>& times);
+	void BeginSection(int id);
+	void EndSection();
+	void EndFrame();
+	void Discard();
+	void Destroy();
+};
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include "pathutil.h"
+#include "imagecache.h"
+#include "texturecontainer.h"
+
+#include "stb_image.h"
+
+namespace ImageCache
+{
+	struct CachedImage
+	{
+		std::shared_ptr<const TextureData> data;
+		unsigned long long lastUse = 0;
+	};
+
+	static const size_t s_Budget = (size_t)1024 * 1024 * 1024;
+
+	static std::mutex s_Mutex;
+	static std::unordered_map<std::string, CachedImage> s_Images;
+	static size_t s_CachedBytes = 0;
+	static unsigned long long s_UseCount = 0;
+
+	static void Evict()
+	{
+		// Images still referenced by textures or uploads stay alive until those let go
+		while (s_CachedBytes > s_Budget && s_Images.size() > 1)
+		{
+			auto oldest = s_Images.begin();
+			for (auto it = s_Images.begin(); it != s_Images.end(); ++it)
+			{
+				if (it->second.lastUse < oldest->second.lastUse)
+					oldest = it;
+			}
+			s_CachedBytes -= oldest->second.data->pixels.size();
+			s_Images.erase(oldest);
+		}
+	}
+
+	static unsigned long long HashBytes(const std::string& bytes)
+	{
+		// FNV-1a
+		unsigned long long hash = 14695981039346656037ull;
+		for (unsigned char c : bytes)
+		{
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static void DecodeImage(const std::string& file, TextureData& result)
+	{
+		// Grey and grey-alpha images keep one and two channels, everything else is
+		// expanded to RGBA. HDR images keep float precision in half floats, 16-bit
+		// images keep their 16 bits
+		const stbi_uc* bytes = (const stbi_uc*)file.data();
+		int length = (int)file.size();
+		int n = 4;
+		stbi_info_from_memory(bytes, length, &result.width, &result.height, &n);
+		int channels = n <= 2 ? std::max(n, 1) : 4;
+		const GLenum pixelFormats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+		const GLenum formats8[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+		const GLenum formats16[] = { GL_R16, GL_RG16, GL_RGB16, GL_RGBA16 };
+		const GLenum formats16F[] = { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F };
+		result.pixelFormat = pixelFormats[channels - 1];
+		size_t pixelSize = channels;
+		void* data = 0;
+		if (stbi_is_hdr_from_memory(bytes, length))
+		{
+			data = stbi_loadf_from_memory(bytes, length, &result.width, &result.height, &n, channels);
+			result.format = formats16F[channels - 1];
+			result.pixelType = GL_FLOAT;
+			pixelSize = channels * sizeof(float);
+		}
+		else if (stbi_is_16_bit_from_memory(bytes, length))
+		{
+			data = stbi_load_16_from_memory(bytes, length, &result.width, &result.height, &n, channels);
+			result.format = formats16[channels - 1];
+			result.pixelType = GL_UNSIGNED_SHORT;
+			pixelSize = channels * sizeof(unsigned short);
+		}
+		else
+		{
+			data = stbi_load_from_memory(bytes, length, &result.width, &result.height, &n, channels);
+			result.format = formats8[channels - 1];
+		}
+		if (!data)
+		{
+			result.log = stbi_failure_reason();
+			return;
+		}
+		unsigned char* pixels = (unsigned char*)data;
+		result.pixels.assign(pixels, pixels + (size_t)result.width * result.height * pixelSize);
+		TextureLevel level;
+		level.width = result.width;
+		level.height = result.height;
+		level.size = result.pixels.size();
+		result.levels.push_back(level);
+		stbi_image_free(data);
+	}
+
+	std::shared_ptr<const TextureData> Decode(const std::string& path)
+	{
+		std::string cleanPath = PathUtil::CleanPath(path);
+		auto result = std::make_shared<TextureData>();
+		std::ifstream fileStream(cleanPath.c_str(), std::ios::binary);
+		if (!fileStream.is_open() || !PathUtil::GetModifiedTime(cleanPath, result->mtime))
+		{
+			result->log = "ERROR: could not load the texture at: " + path + " (file not found)\n";
+			return result;
+		}
+		std::stringstream fileData;
+		fileData << fileStream.rdbuf();
+		std::string file = fileData.str();
+
+		// A file copied over another can keep its modification time, the size
+		// and a hash of the contents have to match as well
+		result->fileSize = file.size();
+		result->fileHash = HashBytes(file);
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			auto found = s_Images.find(cleanPath);
+			if (found != s_Images.end() && found->second.data->mtime == result->mtime &&
+				found->second.data->fileSize == result->fileSize && found->second.data->fileHash == result->fileHash)
+			{
+				found->second.lastUse = ++s_UseCount;
+				return found->second.data;
+			}
+		}
+
+		// Decoded outside the lock so workers don't wait on each other
+		if (TextureContainer::IsContainer(cleanPath))
+			TextureContainer::Load(file, cleanPath, *result);
+		else if (file.size() > INT_MAX)
+			result->log = "file too large";
+		else
+			DecodeImage(file, *result);
+		if (result->pixels.empty())
+		{
+			result->log = "ERROR: could not load the texture at: " + path + " (" + result->log + ")\n";
+			return result;
+		}
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		CachedImage& cached = s_Images[cleanPath];
+		if (cached.data)
+			s_CachedBytes -= cached.data->pixels.size();
+		cached.data = result;
+		cached.lastUse = ++s_UseCount;
+		s_CachedBytes += result->pixels.size();
+		Evict();
+		return result;
+	}
+
+	void Invalidate(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		auto found = s_Images.find(PathUtil::CleanPath(path));
+		if (found == s_Images.end())
+			return;
+		s_CachedBytes -= found->second.data->pixels.size();
+		s_Images.erase(found);
+	}
+
+	size_t GetCachedBytes()
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		return s_CachedBytes;
+	}
+}
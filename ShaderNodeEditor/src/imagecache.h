@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ctime>
+
+#include <GL/glew.h>
+
+// Byte range of one mip level in the image's pixels
+struct TextureLevel
+{
+	int width = 0;
+	int height = 0;
+	size_t offset = 0;
+	size_t size = 0;
+};
+
+// Image decoded to R, RG or RGBA (8-bit, 16-bit or float), or the
+// block-compressed levels of a DDS/KTX2 file
+struct TextureData
+{
+	int width = 0;
+	int height = 0;
+	GLenum format = GL_RGBA8;
+	// Format and type of the pixels of uncompressed images
+	GLenum pixelFormat = GL_RGBA;
+	GLenum pixelType = GL_UNSIGNED_BYTE;
+	bool isCompressed = false;
+	std::vector<TextureLevel> levels;
+	std::vector<unsigned char> pixels;
+	// The file the image was decoded from
+	time_t mtime = 0;
+	unsigned long long fileSize = 0;
+	unsigned long long fileHash = 0;
+	std::string log;
+};
+
+// Decoded images kept in memory by path, modification time, size and content
+// hash, so a texture is decoded again only after its file changes. The least
+// recently used images are dropped past a memory budget. Safe to call from workers
+namespace ImageCache
+{
+	std::shared_ptr<const TextureData> Decode(const std::string& path);
+	void Invalidate(const std::string& path);
+	size_t GetCachedBytes();
+}
@@ -1,3 +1,4 @@
+#include <iostream>
 #include <string>
 
 #include <GL/glew.h>
@@ -65,10 +66,16 @@ int InitializeGL(GLFWwindow*& window)
 {
 	if (!glfwInit())
 		return -1;
-	
+
+	// The editor uses direct state access throughout, which is core in 4.5
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
 	window = glfwCreateWindow(wWindow, hWindow, wTitle.c_str(), NULL, NULL);
 	if (!window)
 	{
+		std::cerr << "ERROR: could not create an OpenGL 4.5 core context" << std::endl;
 		glfwTerminate();
 		return -1;
 	}
@@ -78,7 +85,14 @@ int InitializeGL(GLFWwindow*& window)
 
 	glfwMakeContextCurrent(window);
 
-	glewInit();
+	// Core profiles don't list their extensions the old way, GLEW has to query them anyway
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK || !(GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access))
+	{
+		std::cerr << "ERROR: OpenGL 4.5 or ARB_direct_state_access is required" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
 
 	glEnable(GL_DEPTH_TEST);
 
@@ -1,4 +1,9 @@
 #include <algorithm>
+#include <vector>
+#include <cctype>
+
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "pathutil.h"
 
@@ -21,4 +26,71 @@ namespace PathUtil
         std::replace(res.begin(), res.end(), '\\', '/');
         return res;
     }
+
+    std::string CleanPath(const std::string& path)
+    {
+        std::string universal = UniversalPath(path);
+        bool isAbsolute = !universal.empty() && universal[0] == '/';
+        std::vector<std::string> parts;
+        size_t begin = 0;
+        while (begin <= universal.size())
+        {
+            size_t end = universal.find('/', begin);
+            if (end == std::string::npos)
+                end = universal.size();
+            std::string part = universal.substr(begin, end - begin);
+            if (part == "..")
+            {
+                if (!parts.empty() && parts.back() != "..")
+                    parts.pop_back();
+                else if (!isAbsolute)
+                    parts.push_back(part);
+            }
+            else if (!part.empty() && part != ".")
+                parts.push_back(part);
+            begin = end + 1;
+        }
+
+        std::string res = isAbsolute ? "/" : "";
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            if (i > 0)
+                res += '/';
+            res += parts[i];
+        }
+        return res;
+    }
+
+    std::string DirectoryOf(const std::string& path)
+    {
+        size_t found = path.find_last_of("/\\");
+        if (found == std::string::npos)
+            return "";
+        return path.substr(0, found + 1);
+    }
+
+    std::string ExtensionOf(const std::string& path)
+    {
+        size_t found = path.find_last_of("./\\");
+        if (found == std::string::npos || path[found] != '.')
+            return "";
+        std::string ext = path.substr(found + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+        return ext;
+    }
+
+    bool GetModifiedTime(const std::string& path, time_t& time)
+    {
+#if defined(_WIN32)
+        struct _stat st;
+        if (_stat(path.c_str(), &st) != 0)
+            return false;
+#else
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            return false;
+#endif
+        time = st.st_mtime;
+        return true;
+    }
 }
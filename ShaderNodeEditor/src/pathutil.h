@@ -2,11 +2,18 @@
 #define __PATHUTIL_H__
 
 #include <string>
+#include <ctime>
 
 namespace PathUtil
 {
 	std::string NativePath(const std::string& path);
 	std::string UniversalPath(const std::string& path);
+	// Universal separators with "." and "dir/.." segments removed
+	std::string CleanPath(const std::string& path);
+	std::string DirectoryOf(const std::string& path);
+	// Lowercase extension without the dot, empty if there is none
+	std::string ExtensionOf(const std::string& path);
+	bool GetModifiedTime(const std::string& path, time_t& time);
 }
 
 #endif
@@ -0,0 +1,212 @@
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+#include "pathutil.h"
+#include "preprocessor.h"
+
+namespace Preprocessor
+{
+	struct ParsedFile
+	{
+		time_t mtime = 0;
+		bool isPragmaOnce = false;
+		int version = 0;
+		// Text between include directives, chunks[i] is followed by includes[i]
+		std::vector<std::string> chunks;
+		std::vector<std::string> includes;
+		std::vector<int> includeLines;
+	};
+
+	static std::mutex s_Mutex;
+	static std::unordered_map<std::string, std::shared_ptr<const ParsedFile>> s_Files;
+
+	static std::string Trim(const std::string& str)
+	{
+		size_t begin = str.find_first_not_of(" \t\r");
+		if (begin == std::string::npos)
+			return "";
+		size_t end = str.find_last_not_of(" \t\r");
+		return str.substr(begin, end - begin + 1);
+	}
+
+	// Matches "# directive argument", returning the trimmed argument
+	static bool ParseDirective(const std::string& line, const char* directive, std::string& argument)
+	{
+		std::string trimmed = Trim(line);
+		if (trimmed.empty() || trimmed[0] != '#')
+			return false;
+		trimmed = Trim(trimmed.substr(1));
+		size_t length = strlen(directive);
+		if (trimmed.compare(0, length, directive) != 0)
+			return false;
+		if (trimmed.size() > length && trimmed[length] != ' ' && trimmed[length] != '\t')
+			return false;
+		argument = Trim(trimmed.substr(length));
+		return true;
+	}
+
+	static std::shared_ptr<const ParsedFile> Parse(const std::string& path, time_t mtime)
+	{
+		// The whole file is read at once, each read may be a round trip on a network mount
+		std::ifstream file(path.c_str());
+		if (!file.is_open())
+			return nullptr;
+		std::stringstream data;
+		data << file.rdbuf();
+		file.close();
+		const std::string source = data.str();
+
+		auto parsed = std::make_shared<ParsedFile>();
+		parsed->mtime = mtime;
+		parsed->chunks.emplace_back();
+		std::string dir = PathUtil::DirectoryOf(path);
+
+		size_t lineBegin = 0;
+		int lineNumber = 1;
+		while (lineBegin < source.size())
+		{
+			size_t lineEnd = source.find('\n', lineBegin);
+			if (lineEnd == std::string::npos)
+				lineEnd = source.size();
+			std::string line = source.substr(lineBegin, lineEnd - lineBegin);
+
+			std::string argument;
+			if (ParseDirective(line, "include", argument))
+			{
+				// Accepts "file", <file> and a bare path, relative to the including file
+				if (argument.size() >= 2 &&
+					((argument.front() == '"' && argument.back() == '"') ||
+					(argument.front() == '<' && argument.back() == '>')))
+					argument = argument.substr(1, argument.size() - 2);
+				parsed->includes.push_back(PathUtil::CleanPath(dir + argument));
+				parsed->includeLines.push_back(lineNumber);
+				parsed->chunks.emplace_back();
+			}
+			else
+			{
+				// The line is kept blank so the line numbers don't shift
+				if (ParseDirective(line, "pragma", argument) && argument == "once")
+					parsed->isPragmaOnce = true;
+				else
+				{
+					if (ParseDirective(line, "version", argument))
+						parsed->version = atoi(argument.c_str());
+					parsed->chunks.back() += line;
+				}
+				parsed->chunks.back() += '\n';
+			}
+			lineBegin = lineEnd + 1;
+			lineNumber++;
+		}
+		return parsed;
+	}
+
+	static std::shared_ptr<const ParsedFile> GetFile(const std::string& path)
+	{
+		time_t mtime = 0;
+		if (!PathUtil::GetModifiedTime(path, mtime))
+			return nullptr;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			auto found = s_Files.find(path);
+			if (found != s_Files.end() && found->second->mtime == mtime)
+				return found->second;
+		}
+
+		// Parsed outside the lock so workers don't wait on each other's reads
+		auto parsed = Parse(path, mtime);
+		if (parsed)
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			s_Files[path] = parsed;
+		}
+		return parsed;
+	}
+
+	static void ExpandFile(const std::string& path, int lineOffset, Output& output, std::vector<std::string>& stack)
+	{
+		auto file = GetFile(path);
+		if (!file)
+		{
+			output.log += "ERROR: could not open the shader at: " + path + "\n";
+			return;
+		}
+
+		int fileNumber = (int)(std::find(output.files.begin(), output.files.end(), path) - output.files.begin());
+		if (fileNumber < output.files.size() && file->isPragmaOnce)
+			return;
+		if (std::find(stack.begin(), stack.end(), path) != stack.end())
+		{
+			output.log += "ERROR: recursive include of " + path + " in " + stack.back() + "\n";
+			return;
+		}
+		if (fileNumber == output.files.size())
+			output.files.push_back(path);
+
+		stack.push_back(path);
+		for (size_t i = 0; i < file->chunks.size(); i++)
+		{
+			output.source += file->chunks[i];
+			if (i >= file->includes.size())
+				break;
+
+			const std::string& include = file->includes[i];
+			size_t includeNumber = std::find(output.files.begin(), output.files.end(), include) - output.files.begin();
+			output.source += "#line " + std::to_string(1 + lineOffset) + " " + std::to_string(includeNumber) + "\n";
+			ExpandFile(include, lineOffset, output, stack);
+			output.source += "#line " + std::to_string(file->includeLines[i] + 1 + lineOffset) + " " +
+				std::to_string(fileNumber) + "\n";
+		}
+		stack.pop_back();
+	}
+
+	void Expand(const std::string& path, Output& output)
+	{
+		output = Output();
+		std::string root = PathUtil::CleanPath(path);
+		auto file = GetFile(root);
+		// Before GLSL 3.30, #line sets the number of the directive itself rather than the next line
+		int lineOffset = file && file->version > 0 && file->version < 330 ? -1 : 0;
+		std::vector<std::string> stack;
+		ExpandFile(root, lineOffset, output, stack);
+	}
+
+	std::vector<std::string> GetDependents(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		std::vector<std::string> dependents;
+		std::unordered_set<std::string> visited;
+		std::vector<std::string> queue = { PathUtil::CleanPath(path) };
+		while (!queue.empty())
+		{
+			std::string current = queue.back();
+			queue.pop_back();
+			for (auto& file : s_Files)
+			{
+				const std::vector<std::string>& includes = file.second->includes;
+				if (std::find(includes.begin(), includes.end(), current) == includes.end())
+					continue;
+				if (visited.insert(file.first).second)
+				{
+					dependents.push_back(file.first);
+					queue.push_back(file.first);
+				}
+			}
+		}
+		return dependents;
+	}
+
+	void Invalidate(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_Files.erase(PathUtil::CleanPath(path));
+	}
+}
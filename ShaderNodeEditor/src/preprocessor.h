@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Expands #include directives in shader sources. Parsed files are kept by
+// path and modification time, so an include shared by many programs is read
+// from disk once and again only after it changes. Safe to call from workers
+namespace Preprocessor
+{
+	struct Output
+	{
+		std::string source;
+		// Every file the source was built from. The index is the source string
+		// number used in the #line directives, so compile errors name the file
+		std::vector<std::string> files;
+		std::string log;
+	};
+
+	void Expand(const std::string& path, Output& output);
+	// Files that include the given file, directly or through other includes
+	std::vector<std::string> GetDependents(const std::string& path);
+	// Forgets the parsed file, for changes within the modification time resolution
+	void Invalidate(const std::string& path);
+}
@@ -1,20 +1,116 @@
 #include <algorithm>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
 
 #include "program.h"
 
 #include "shaders.h"
+#include "programcache.h"
+#include "preprocessor.h"
+#include "pathutil.h"
+#include "stagecache.h"
+#include "textureformat.h"
+
+// Finds "layout(<format>, ...) uniform image2D name" declarations, the format
+// of an image uniform is not part of what the GL reflects
+// Comments are blanked out, line breaks are kept
+static std::string StripComments(const std::string& source)
+{
+	std::string res = source;
+	size_t i = 0;
+	while (i + 1 < res.size())
+	{
+		if (res[i] == '/' && res[i + 1] == '/')
+		{
+			for (; i < res.size() && res[i] != '\n'; i++)
+				res[i] = ' ';
+		}
+		else if (res[i] == '/' && res[i + 1] == '*')
+		{
+			size_t end = res.find("*/", i + 2);
+			end = end == std::string::npos ? res.size() : end + 2;
+			for (; i < end; i++)
+			{
+				if (res[i] != '\n')
+					res[i] = ' ';
+			}
+		}
+		else
+			i++;
+	}
+	return res;
+}
+
+static void ParseImageFormats(const std::string& code, std::unordered_map<std::string, GLenum>& formats)
+{
+	// Commented out declarations don't count
+	std::string source = StripComments(code);
+	auto isIdentifier = [](char c) { return isalnum((unsigned char)c) || c == '_'; };
+	size_t found = source.find("image2D");
+	while (found != std::string::npos)
+	{
+		size_t typeBegin = found;
+		if (typeBegin > 0 && (source[typeBegin - 1] == 'i' || source[typeBegin - 1] == 'u'))
+			typeBegin--;
+		size_t nameBegin = source.find_first_not_of(" \t\r\n", found + 7);
+		bool isDeclaration = (typeBegin == 0 || !isIdentifier(source[typeBegin - 1])) &&
+			nameBegin != std::string::npos && !isIdentifier(source[found + 7]);
+		if (isDeclaration)
+		{
+			size_t nameEnd = nameBegin;
+			while (nameEnd < source.size() && isIdentifier(source[nameEnd]))
+				nameEnd++;
+			std::string name = source.substr(nameBegin, nameEnd - nameBegin);
+
+			// The layout qualifier is in the same declaration, before the type
+			size_t declBegin = source.find_last_of(";{}", typeBegin);
+			declBegin = declBegin == std::string::npos ? 0 : declBegin + 1;
+			std::string decl = source.substr(declBegin, typeBegin - declBegin);
+			size_t layout = decl.find("layout");
+			size_t open = decl.find('(', layout);
+			size_t close = decl.find(')', open);
+			if (layout != std::string::npos && open != std::string::npos && close != std::string::npos)
+			{
+				std::stringstream qualifiers(decl.substr(open + 1, close - open - 1));
+				std::string qualifier;
+				while (std::getline(qualifiers, qualifier, ','))
+				{
+					qualifier.erase(std::remove_if(qualifier.begin(), qualifier.end(),
+						[](char c) { return isspace((unsigned char)c); }), qualifier.end());
+					GLenum format = TextureFormat::FromQualifier(qualifier);
+					if (format != 0 && !name.empty())
+						formats[name] = format;
+				}
+			}
+		}
+		found = source.find("image2D", found + 7);
+	}
+}
 
 Program::Program() :
 	m_Name(""),
 	m_Program(-1),
-	m_NeedInit(true)
+	m_IsSeparable(false),
+	m_Pipeline(-1),
+	m_NeedInit(true),
+	m_NeedRespecialize(false),
+	m_IsLoadForced(false),
+	m_PendingProgram(-1),
+	m_IsPendingCached(false)
 {
 }
 
 Program::Program(const char* name) :
 	m_Name(name),
 	m_Program(-1),
-	m_NeedInit(true)
+	m_IsSeparable(false),
+	m_Pipeline(-1),
+	m_NeedInit(true),
+	m_NeedRespecialize(false),
+	m_IsLoadForced(false),
+	m_PendingProgram(-1),
+	m_IsPendingCached(false)
 {
 }
 
@@ -38,31 +134,124 @@ GLuint Program::GetProgram()
 	return m_Program;
 }
 
-std::vector<std::string> Program::GetShaderFiles()
+GLuint Program::GetPipeline()
+{
+	return m_Pipeline;
+}
+
+const std::vector<GLuint>& Program::GetStages() const
+{
+	return m_Stages;
+}
+
+bool Program::IsLinked()
+{
+	return m_Program != -1 || m_Pipeline != -1;
+}
+
+void Program::SetSeparable(bool isSeparable)
+{
+	m_IsSeparable = isSeparable;
+	m_NeedInit = true;
+}
+
+bool Program::IsSeparable()
+{
+	return m_IsSeparable;
+}
+
+const std::vector<std::string>& Program::GetShaderFiles() const
 {
 	return m_ShaderFiles;
 }
 
-std::vector<GLenum> Program::GetShaderTypes()
+const std::vector<GLenum>& Program::GetShaderTypes() const
 {
 	return m_ShaderTypes;
 }
 
-std::vector<Uniform> Program::GetUniforms()
+const std::vector<std::vector<std::string>>& Program::GetSourceFiles() const
+{
+	return m_SourceFiles;
+}
+
+const std::string& Program::GetErrorLog() const
+{
+	return m_ErrorLog;
+}
+
+bool Program::DependsOn(const std::string& path) const
+{
+	std::string cleanPath = PathUtil::CleanPath(path);
+	for (auto& file : m_ShaderFiles)
+	{
+		if (PathUtil::CleanPath(file) == cleanPath)
+			return true;
+	}
+	for (auto& stageFiles : m_SourceFiles)
+	{
+		if (std::find(stageFiles.begin(), stageFiles.end(), cleanPath) != stageFiles.end())
+			return true;
+	}
+	return false;
+}
+
+const std::vector<Uniform>& Program::GetUniforms() const
 {
 	return m_Uniforms;
 }
 
-std::vector<UniformBlock> Program::GetUniformBlocks()
+const std::vector<ProgramLocation>& Program::GetUniformLocations(const std::string& name) const
+{
+	static const std::vector<ProgramLocation> none;
+	auto found = m_UniformLocations.find(name);
+	return found != m_UniformLocations.end() ? found->second : none;
+}
+
+const std::vector<UniformBlock>& Program::GetUniformBlocks() const
 {
 	return m_UniformBlocks;
 }
 
-std::vector<BufferBlock> Program::GetBufferBlocks()
+const std::vector<BufferBlock>& Program::GetBufferBlocks() const
 {
 	return m_BufferBlocks;
 }
 
+const std::vector<Spirv::SpecConstant>& Program::GetSpecConstants() const
+{
+	return m_SpecConstants;
+}
+
+GLenum Program::GetImageFormat(const std::string& name) const
+{
+	auto found = m_ImageFormats.find(name);
+	return found != m_ImageFormats.end() ? found->second : GL_RGBA8;
+}
+
+void Program::SetSpecConstant(const std::string& name, GLuint value)
+{
+	// The program is specialized again from the sources already loaded, on the next Poll()
+	for (auto& constant : m_SpecConstants)
+	{
+		if (constant.name == name && constant.value != value)
+		{
+			constant.value = value;
+			m_NeedRespecialize = true;
+		}
+	}
+}
+
+const UniformBlock& Program::GetUniformBlock(int ix) const
+{
+	return m_UniformBlocks[ix];
+}
+
+const BufferBlock& Program::GetBufferBlock(int ix) const
+{
+	return m_BufferBlocks[ix];
+}
+
 void Program::AddShader(const char* file, GLenum type)
 {
 	m_ShaderFiles.push_back(file);
@@ -83,113 +272,482 @@ void Program::SetShaderType(int ix, GLenum type)
 	m_NeedInit = true;
 }
 
-void Program::Initialize()
+void Program::Initialize(ThreadPool& workers)
+{
+	LoadSources(workers);
+	m_IsLoadForced = true;
+	m_NeedInit = false;
+}
+
+void Program::Reload(ThreadPool& workers)
+{
+	// Replaces a load already in flight, it may have read the files before they changed
+	LoadSources(workers);
+}
+
+bool Program::Poll()
+{
+	// Sources read on a worker are compiled here, on the GL thread
+	if (m_Loading.valid() && m_Loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		ProgramSources sources = m_Loading.get();
+		// Missing files and include errors show in the program's error log right away,
+		// even when the sources are not compiled again
+		m_LoadLog = sources.log;
+		if (!m_LoadLog.empty())
+			m_ErrorLog = m_LoadLog;
+		m_SourceFiles = sources.files;
+		MergeSpecConstants(sources);
+		m_Sources = sources;
+		m_NeedRespecialize = false;
+		std::string key = MakeKey(sources);
+		// Reloads resubmit only if the expanded sources or the stage list changed since the last submission,
+		// sources that already failed are not compiled again. An explicit initialize always rebuilds
+		bool hasPending = m_PendingProgram != -1 || !m_PendingStages.empty();
+		const std::string& lastKey = hasPending ? m_PendingKey : m_SourceKey;
+		bool isChanged = (!IsLinked() && !hasPending) || key != lastKey;
+		if (m_IsLoadForced || (isChanged && key != m_FailedKey))
+			Submit(sources, key);
+		m_IsLoadForced = false;
+	}
+	else if (m_NeedRespecialize && !m_Loading.valid())
+	{
+		std::string key = MakeKey(m_Sources);
+		if (key != m_FailedKey)
+			Submit(m_Sources, key);
+		m_NeedRespecialize = false;
+	}
+
+	if (m_PendingProgram == -1 && m_PendingStages.empty())
+		return false;
+	if (m_PendingProgram != -1 && !IsProgramComplete(m_PendingProgram))
+		return false;
+	for (auto stage : m_PendingStages)
+	{
+		if (!StageCache::IsComplete(stage))
+			return false;
+	}
+
+	// The new program was built on the side, it only replaces the current one if it linked
+	bool isLinked = true;
+	if (m_PendingProgram != -1)
+	{
+		GLint status = GL_FALSE;
+		glGetProgramiv(m_PendingProgram, GL_LINK_STATUS, &status);
+		isLinked = status == GL_TRUE;
+	}
+	for (auto stage : m_PendingStages)
+		isLinked = isLinked && StageCache::IsLinked(stage);
+	if (!isLinked)
+	{
+		m_ErrorLog = m_LoadLog;
+		for (int i = 0; i < m_PendingShaders.size(); i++)
+			m_ErrorLog += AnnotateLog(GetShaderLog(m_PendingShaders[i]), i);
+		if (m_PendingProgram != -1)
+			m_ErrorLog += GetProgramLog(m_PendingProgram);
+		for (int i = 0; i < m_PendingStages.size(); i++)
+		{
+			if (!StageCache::IsLinked(m_PendingStages[i]))
+				m_ErrorLog += AnnotateLog(StageCache::GetLog(m_PendingStages[i]), i);
+		}
+		m_FailedKey = m_PendingKey;
+		DiscardPending();
+		return false;
+	}
+	m_ErrorLog = "";
+	m_FailedKey = "";
+
+	if (m_PendingProgram != -1 && !m_IsPendingCached)
+		ProgramCache::Save(m_PendingKey, m_PendingProgram);
+	DeleteLinked();
+	if (m_PendingProgram != -1)
+		m_Program = m_PendingProgram;
+	else
+	{
+		glCreateProgramPipelines(1, &m_Pipeline);
+		for (int i = 0; i < m_PendingStages.size(); i++)
+			glUseProgramStages(m_Pipeline, ShaderStageBit(m_PendingStageTypes[i]), m_PendingStages[i]);
+		m_Stages.swap(m_PendingStages);
+	}
+	m_SourceKey = m_PendingKey;
+	m_ImageFormats.swap(m_PendingImageFormats);
+	m_PendingProgram = -1;
+	DiscardPending();
+	Reflect();
+	return true;
+}
+
+bool Program::IsPending()
+{
+	return m_Loading.valid() || m_PendingProgram != -1 || !m_PendingStages.empty();
+}
+
+void Program::LoadSources(ThreadPool& workers)
+{
+	// The worker gets its own copy of the stage list, a load started before
+	// an edit is simply replaced and its result dropped
+	std::vector<std::string> files = m_ShaderFiles;
+	std::vector<GLenum> types = m_ShaderTypes;
+	m_Loading = workers.Submit<ProgramSources>([files, types]()
+	{
+		ProgramSources result;
+		for (auto& file : files)
+		{
+			// Precompiled SPIR-V modules are passed through as they are
+			std::vector<Spirv::SpecConstant> constants;
+			if (PathUtil::ExtensionOf(file) == "spv")
+			{
+				std::string module = LoadShaderModule(file);
+				if (module.empty())
+					result.log += "ERROR: could not open the shader at: " + file + "\n";
+				else if (!Spirv::IsModule(module))
+					result.log += "ERROR: " + file + " is not a SPIR-V module\n";
+				Spirv::GetSpecConstants(module, constants);
+				result.sources.push_back(module);
+				result.files.push_back({ PathUtil::CleanPath(file) });
+				result.constants.push_back(constants);
+				continue;
+			}
+			Preprocessor::Output output;
+			Preprocessor::Expand(file, output);
+			result.sources.push_back(output.source);
+			result.files.push_back(output.files);
+			result.constants.push_back(constants);
+			result.log += output.log;
+			ParseImageFormats(output.source, result.imageFormats);
+		}
+		result.types = types;
+		return result;
+	});
+}
+
+void Program::Submit(const ProgramSources& sources, const std::string& key)
+{
+	// A newer submission replaces one that is still compiling
+	DiscardPending();
+
+	// Modules the driver can't take fail like a compile error, nothing is built for them
+	if (!IsSpirvSupported())
+	{
+		std::string log;
+		for (int i = 0; i < sources.sources.size(); i++)
+		{
+			if (Spirv::IsModule(sources.sources[i]))
+				log += "ERROR: " + sources.files[i].front() + ": SPIR-V not supported by this driver\n";
+		}
+		if (!log.empty())
+		{
+			m_ErrorLog = m_LoadLog + log;
+			m_FailedKey = key;
+			return;
+		}
+	}
+
+	// 0. Link & Compile, unless the cache has a binary built from the same sources.
+	// Nothing here waits for the driver, the current program stays in use until Poll() sees it finish
+	m_PendingKey = key;
+	m_PendingImageFormats = sources.imageFormats;
+	if (m_IsSeparable)
+	{
+		// Each stage is a separable program of its own, shared by all programs with the same stage source
+		for (int i = 0; i < sources.sources.size(); i++)
+		{
+			std::vector<GLuint> ids, values;
+			GetStageConstants(sources, i, ids, values);
+			ids.insert(ids.end(), values.begin(), values.end());
+			std::string stageKey = ProgramCache::MakeKey({ sources.sources[i] }, { sources.types[i] }, true, ids);
+			ids.resize(values.size());
+			m_PendingStages.push_back(StageCache::Acquire(stageKey, sources.types[i], sources.sources[i], ids, values));
+		}
+		m_PendingStageTypes = sources.types;
+		return;
+	}
+	m_PendingProgram = ProgramCache::Load(key);
+	m_IsPendingCached = m_PendingProgram != -1;
+	if (!m_IsPendingCached)
+	{
+		// The shaders are kept until the link completes, for their info logs
+		for (int i = 0; i < sources.sources.size(); i++)
+		{
+			std::vector<GLuint> ids, values;
+			GetStageConstants(sources, i, ids, values);
+			m_PendingShaders.push_back(CreateShader(sources.types[i], sources.sources[i], ids, values));
+		}
+		m_PendingProgram = CreateProgram(m_PendingShaders);
+	}
+}
+
+std::string Program::MakeKey(const ProgramSources& sources)
+{
+	// Specialization constant values are part of the key, each set of values is a different program
+	std::vector<GLuint> constants;
+	for (int i = 0; i < sources.sources.size(); i++)
+	{
+		std::vector<GLuint> ids, values;
+		GetStageConstants(sources, i, ids, values);
+		constants.insert(constants.end(), ids.begin(), ids.end());
+		constants.insert(constants.end(), values.begin(), values.end());
+	}
+	return ProgramCache::MakeKey(sources.sources, sources.types, m_IsSeparable, constants);
+}
+
+void Program::GetStageConstants(const ProgramSources& sources, int stage,
+	std::vector<GLuint>& ids, std::vector<GLuint>& values)
+{
+	// Only the constants the module declares are passed to glSpecializeShader
+	if (stage >= sources.constants.size())
+		return;
+	for (auto& constant : sources.constants[stage])
+	{
+		for (auto& current : m_SpecConstants)
+		{
+			if (current.name == constant.name)
+			{
+				ids.push_back(constant.id);
+				values.push_back(current.value);
+				break;
+			}
+		}
+	}
+}
+
+void Program::MergeSpecConstants(const ProgramSources& sources)
+{
+	// Values set by the user survive a reload as long as the constant keeps its name and type
+	std::vector<Spirv::SpecConstant> merged;
+	for (auto& stageConstants : sources.constants)
+	{
+		for (auto& constant : stageConstants)
+		{
+			auto isSame = [&constant](const Spirv::SpecConstant& c) { return c.name == constant.name; };
+			if (std::find_if(merged.begin(), merged.end(), isSame) != merged.end())
+				continue;
+			merged.push_back(constant);
+			auto current = std::find_if(m_SpecConstants.begin(), m_SpecConstants.end(), isSame);
+			if (current != m_SpecConstants.end() && current->type == constant.type)
+				merged.back().value = current->value;
+		}
+	}
+	m_SpecConstants.swap(merged);
+}
+
+void Program::DiscardPending()
+{
+	if (m_PendingProgram != -1)
+		glDeleteProgram(m_PendingProgram);
+	m_PendingProgram = -1;
+	std::for_each(m_PendingShaders.begin(), m_PendingShaders.end(), glDeleteShader);
+	m_PendingShaders.clear();
+	std::for_each(m_PendingStages.begin(), m_PendingStages.end(), StageCache::Release);
+	m_PendingStages.clear();
+	m_PendingKey = "";
+}
+
+void Program::DeleteLinked()
 {
 	if (m_Program != -1)
 		glDeleteProgram(m_Program);
+	m_Program = -1;
+	if (m_Pipeline != -1)
+		glDeleteProgramPipelines(1, &m_Pipeline);
+	m_Pipeline = -1;
+	std::for_each(m_Stages.begin(), m_Stages.end(), StageCache::Release);
+	m_Stages.clear();
+}
+
+std::string Program::AnnotateLog(const std::string& log, int stage)
+{
+	// Drivers print locations as "N(line)" or "N:line" where N is the #line
+	// source string number, which is replaced with the name of the file
+	if (stage >= m_SourceFiles.size())
+		return log;
+	const std::vector<std::string>& files = m_SourceFiles[stage];
+	std::stringstream ssLog(log);
+	std::string line;
+	std::string res;
+	while (std::getline(ssLog, line))
+	{
+		size_t begin = 0;
+		while (begin < line.size())
+		{
+			size_t end = begin;
+			while (end < line.size() && isdigit((unsigned char)line[end]))
+				end++;
+			bool isToken = begin == 0 || line[begin - 1] == ' ';
+			if (isToken && end > begin && end < line.size() && (line[end] == '(' || line[end] == ':'))
+			{
+				int number = atoi(line.substr(begin, end - begin).c_str());
+				if (number < files.size())
+					line.replace(begin, end - begin, files[number]);
+				break;
+			}
+			begin = end + 1;
+		}
+		res += line + "\n";
+	}
+	return res;
+}
+
+// SPIR-V modules stripped of their debug names reflect empty names, they are named
+// after their location, binding or offset instead so they don't collapse into one
+static std::string ResourceName(const char* name, const char* prefix, int key)
+{
+	return name[0] != 0 ? std::string(name) : prefix + std::to_string(key);
+}
 
-	// 0. Link & Compile
-	std::vector<GLuint> shaderList;
-	for (int i = 0; i < m_ShaderFiles.size(); i++)
-		shaderList.push_back(CreateShader(m_ShaderTypes[i], LoadShader(m_ShaderFiles[i])));
-	m_Program = CreateProgram(shaderList);
-	std::for_each(shaderList.begin(), shaderList.end(), glDeleteShader);
+void Program::Reflect()
+{
+	std::vector<Uniform>().swap(m_Uniforms);
+	m_UniformLocations.clear();
+	std::vector<UniformBlock>().swap(m_UniformBlocks);
+	std::vector<BufferBlock>().swap(m_BufferBlocks);
 
+	// A separable program is reflected stage by stage, uniforms and blocks
+	// declared in several stages are merged by name
+	if (m_Program != -1)
+		ReflectProgram(m_Program);
+	for (auto stage : m_Stages)
+		ReflectProgram(stage);
+}
+
+void Program::ReflectProgram(GLuint program)
+{
 	int n = 0;
 	// 1. Get Uniforms
-	std::vector<Uniform>().swap(m_Uniforms);
 	std::vector<Uniform> uniforms;
-	glGetProgramInterfaceiv(m_Program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &n);
+	glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &n);
 	for (int i = 0; i < n; i++)
 	{
 		const GLenum props[] =
 		{
 			GL_TYPE,
 			GL_NAME_LENGTH,
-			GL_ARRAY_SIZE
+			GL_ARRAY_SIZE,
+			GL_LOCATION,
+			GL_BLOCK_INDEX,
+			GL_OFFSET,
+			GL_ARRAY_STRIDE,
+			GL_MATRIX_STRIDE
 		};
-		std::vector<GLint> values(3);
-		glGetProgramResourceiv(m_Program, GL_UNIFORM, i, 3, props, 3, NULL, &values[0]);
-		char* name = new char[values[1]];
-		glGetProgramResourceName(m_Program, GL_UNIFORM, i, values[1], NULL, name);
-		int loc = glGetUniformLocation(m_Program, name);
-		m_Uniforms.push_back(Uniform{ ShaderVar(values[0], name, values[2]), loc });
-		uniforms.push_back(Uniform{ ShaderVar(values[0], name, values[2]), loc });
-		delete[] name;
+		std::vector<GLint> values(8);
+		glGetProgramResourceiv(program, GL_UNIFORM, i, 8, props, 8, NULL, &values[0]);
+		std::vector<char> nameData(values[1] + 1);
+		glGetProgramResourceName(program, GL_UNIFORM, i, values[1], NULL, &nameData[0]);
+		std::string name = values[4] == -1 ? ResourceName(&nameData[0], "location_", values[3]) :
+			ResourceName(&nameData[0], "offset_", values[5]);
+		uniforms.push_back(Uniform{ ShaderVar(values[0], name.c_str(), values[2]), values[3] });
+		uniforms.back().var.SetLayout(values[5], values[6], values[7]);
+		// Block members are listed by their blocks only
+		if (values[4] == -1)
+		{
+			std::vector<ProgramLocation>& locations = m_UniformLocations[name];
+			if (locations.empty())
+				m_Uniforms.push_back(uniforms.back());
+			locations.push_back({ program, values[3] });
+		}
 	}
 
 	// 2. Get Uniform Blocks
-	std::vector<UniformBlock>().swap(m_UniformBlocks);
-	glGetProgramInterfaceiv(m_Program, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &n);
+	glGetProgramInterfaceiv(program, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &n);
 	for (int i = 0; i < n; i++)
 	{
 		const GLenum props[] =
 		{
 			GL_NAME_LENGTH,
 			GL_NUM_ACTIVE_VARIABLES,
-			GL_BUFFER_BINDING
+			GL_BUFFER_BINDING,
+			GL_BUFFER_DATA_SIZE
 		};
-		std::vector<GLint> values(3);
-		glGetProgramResourceiv(m_Program, GL_UNIFORM_BLOCK, i, 3, props, 3, NULL, &values[0]);
-		char* name = new char[values[0]];
-		glGetProgramResourceName(m_Program, GL_UNIFORM_BLOCK, i, values[0], NULL, name);
-		m_UniformBlocks.push_back(UniformBlock(name, values[2]));
-		m_UniformBlocks[i].SetBinding(glGetUniformBlockIndex(m_Program, name));
-		const GLenum prop = GL_ACTIVE_VARIABLES;
-		std::vector<GLint> varIDs(values[1]);
-		glGetProgramResourceiv(m_Program, GL_UNIFORM_BLOCK, i, 1, &prop, values[1], NULL, &varIDs[0]);
-		for (int j = 0; j < values[1]; j++)
+		std::vector<GLint> values(4);
+		glGetProgramResourceiv(program, GL_UNIFORM_BLOCK, i, 4, props, 4, NULL, &values[0]);
+		std::vector<char> nameData(values[0] + 1);
+		glGetProgramResourceName(program, GL_UNIFORM_BLOCK, i, values[0], NULL, &nameData[0]);
+		std::string name = ResourceName(&nameData[0], "binding_", values[2]);
+		auto found = std::find_if(m_UniformBlocks.begin(), m_UniformBlocks.end(),
+			[&](const UniformBlock& block) { return block.GetName() == name; });
+		int index = found - m_UniformBlocks.begin();
+		if (found == m_UniformBlocks.end())
 		{
-			m_UniformBlocks[i].AddUniform(uniforms[varIDs[j]]);
-			m_Uniforms.erase(m_Uniforms.begin() + varIDs[j]);
+			UniformBlock block(name.c_str(), values[2]);
+			block.SetSize(values[3]);
+			// Each block gets its own binding point, equal to its index
+			block.SetIndex(index);
+			block.SetBinding(index);
+			const GLenum prop = GL_ACTIVE_VARIABLES;
+			std::vector<GLint> varIDs(values[1]);
+			glGetProgramResourceiv(program, GL_UNIFORM_BLOCK, i, 1, &prop, values[1], NULL, &varIDs[0]);
+			for (int j = 0; j < values[1]; j++)
+				block.AddUniform(uniforms[varIDs[j]]);
+			m_UniformBlocks.push_back(block);
 		}
-		delete[] name;
+		glUniformBlockBinding(program, i, index);
+		m_UniformBlocks[index].AddLocation({ program, i });
 	}
 
 	// 3. Get Shader Storage Blocks
 	std::vector<ShaderVar> bufferVars;
-	glGetProgramInterfaceiv(m_Program, GL_BUFFER_VARIABLE, GL_ACTIVE_RESOURCES, &n);
+	// Stride of the trailing unsized array of each variable, 0 if it has none
+	std::vector<int> bufferVarStrides;
+	glGetProgramInterfaceiv(program, GL_BUFFER_VARIABLE, GL_ACTIVE_RESOURCES, &n);
 	for (int i = 0; i < n; i++)
 	{
 		const GLenum props[] =
 		{
 			GL_TYPE,
 			GL_NAME_LENGTH,
-			GL_ARRAY_SIZE
+			GL_ARRAY_SIZE,
+			GL_OFFSET,
+			GL_ARRAY_STRIDE,
+			GL_MATRIX_STRIDE,
+			GL_TOP_LEVEL_ARRAY_SIZE,
+			GL_TOP_LEVEL_ARRAY_STRIDE
 		};
-		std::vector<GLint> values(3);
-		glGetProgramResourceiv(m_Program, GL_BUFFER_VARIABLE, i, 3, props, 3, NULL, &values[0]);
-		char* name = new char[values[1]];
-		glGetProgramResourceName(m_Program, GL_BUFFER_VARIABLE, i, values[1], NULL, name);
-		int loc = glGetUniformLocation(m_Program, name);
-		bufferVars.push_back(ShaderVar(values[0], name, values[2]));
-		delete[] name;
+		std::vector<GLint> values(8);
+		glGetProgramResourceiv(program, GL_BUFFER_VARIABLE, i, 8, props, 8, NULL, &values[0]);
+		std::vector<char> nameData(values[1] + 1);
+		glGetProgramResourceName(program, GL_BUFFER_VARIABLE, i, values[1], NULL, &nameData[0]);
+		bufferVars.push_back(ShaderVar(values[0], ResourceName(&nameData[0], "offset_", values[3]).c_str(), values[2]));
+		bufferVars.back().SetLayout(values[3], values[4], values[5]);
+		bufferVarStrides.push_back(values[6] == 0 ? values[7] : 0);
 	}
-	std::vector<BufferBlock>().swap(m_BufferBlocks);
-	glGetProgramInterfaceiv(m_Program, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &n);
+	glGetProgramInterfaceiv(program, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &n);
 	for (int i = 0; i < n; i++)
 	{
 		const GLenum props[] =
 		{
 			GL_NAME_LENGTH,
 			GL_NUM_ACTIVE_VARIABLES,
-			GL_BUFFER_BINDING
+			GL_BUFFER_BINDING,
+			GL_BUFFER_DATA_SIZE
 		};
-		std::vector<GLint> values(3);
-		glGetProgramResourceiv(m_Program, GL_SHADER_STORAGE_BLOCK, i, 3, props, 3, NULL, &values[0]);
-		char* name = new char[values[0]];
-		glGetProgramResourceName(m_Program, GL_SHADER_STORAGE_BLOCK, i, values[0], NULL, name);
-		m_BufferBlocks.push_back(BufferBlock(name, values[2]));
-		m_BufferBlocks[i].SetBinding(glGetProgramResourceIndex(m_Program, GL_SHADER_STORAGE_BLOCK, name));
-		const GLenum prop = GL_ACTIVE_VARIABLES;
-		std::vector<GLint> varIDs(values[1]);
-		glGetProgramResourceiv(m_Program, GL_SHADER_STORAGE_BLOCK, i, 1, &prop, values[1], NULL, &varIDs[0]);
-		for (int j = 0; j < values[1]; j++)
-			m_BufferBlocks[i].AddVar(bufferVars[varIDs[j]]);
-		delete[] name;
+		std::vector<GLint> values(4);
+		glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, i, 4, props, 4, NULL, &values[0]);
+		std::vector<char> nameData(values[0] + 1);
+		glGetProgramResourceName(program, GL_SHADER_STORAGE_BLOCK, i, values[0], NULL, &nameData[0]);
+		std::string name = ResourceName(&nameData[0], "binding_", values[2]);
+		auto found = std::find_if(m_BufferBlocks.begin(), m_BufferBlocks.end(),
+			[&](const BufferBlock& block) { return block.GetName() == name; });
+		int index = found - m_BufferBlocks.begin();
+		if (found == m_BufferBlocks.end())
+		{
+			BufferBlock block(name.c_str(), values[2]);
+			block.SetSize(values[3]);
+			block.SetIndex(index);
+			block.SetBinding(index);
+			const GLenum prop = GL_ACTIVE_VARIABLES;
+			std::vector<GLint> varIDs(values[1]);
+			glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, i, 1, &prop, values[1], NULL, &varIDs[0]);
+			for (int j = 0; j < values[1]; j++)
+			{
+				block.AddVar(bufferVars[varIDs[j]]);
+				if (bufferVarStrides[varIDs[j]] > 0)
+					block.SetStride(bufferVarStrides[varIDs[j]]);
+			}
+			m_BufferBlocks.push_back(block);
+		}
+		glShaderStorageBlockBinding(program, i, index);
+		m_BufferBlocks[index].AddLocation({ program, i });
 	}
-
-	m_NeedInit = false;
 }
 
 bool Program::NeedsInit()
@@ -199,7 +757,14 @@ bool Program::NeedsInit()
 
 void Program::Destroy()
 {
-	if (m_Program != -1)
-		glDeleteProgram(m_Program);
-	m_Program = -1;
+	DeleteLinked();
+	m_SourceKey = "";
+	m_UniformLocations.clear();
+	m_LoadLog = "";
+	m_ErrorLog = "";
+	m_FailedKey = "";
+	std::vector<std::vector<std::string>>().swap(m_SourceFiles);
+	m_Loading = std::future<ProgramSources>();
+	m_IsLoadForced = false;
+	DiscardPending();
 }
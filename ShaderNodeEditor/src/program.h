@@ -1,21 +1,71 @@
 #pragma once
 
+#include <future>
+#include <unordered_map>
+
 #include "uniform.h"
 #include "bufferblock.h"
+#include "threadpool.h"
+#include "spirv.h"
+
+// Sources of every stage, read and expanded on a worker thread
+struct ProgramSources
+{
+	std::vector<std::string> sources;
+	std::vector<GLenum> types;
+	// Files each stage was expanded from, indexed by #line source string number
+	std::vector<std::vector<std::string>> files;
+	// Specialization constants of each stage, empty unless the stage is a SPIR-V module
+	std::vector<std::vector<Spirv::SpecConstant>> constants;
+	// Format qualifiers of the image uniforms declared in GLSL stages, by name
+	std::unordered_map<std::string, GLenum> imageFormats;
+	std::string log;
+};
 
 class Program
 {
 private:
 	std::string m_Name;
 	GLuint m_Program;
+	// Separable programs are a pipeline of stage programs shared through the stage cache
+	bool m_IsSeparable;
+	GLuint m_Pipeline;
+	std::vector<GLuint> m_Stages;
 	std::vector<std::string> m_ShaderFiles;
 	std::vector<GLenum> m_ShaderTypes;
 
 	std::vector<Uniform> m_Uniforms;
+	// Every program each uniform is declared in, by name
+	std::unordered_map<std::string, std::vector<ProgramLocation>> m_UniformLocations;
 	std::vector<UniformBlock> m_UniformBlocks;
 	std::vector<BufferBlock> m_BufferBlocks;
+	// Specialization constants of all SPIR-V stages by name, values are kept across reloads
+	std::vector<Spirv::SpecConstant> m_SpecConstants;
+	std::unordered_map<std::string, GLenum> m_ImageFormats;
 
 	bool m_NeedInit;
+	// Cache key of the sources the current program was linked from
+	std::string m_SourceKey;
+	// Files each stage of the last loaded sources was expanded from
+	std::vector<std::vector<std::string>> m_SourceFiles;
+	// Last loaded sources, submitted again when a specialization constant changes
+	ProgramSources m_Sources;
+	bool m_NeedRespecialize;
+	// Sources still being read by a worker, compiled once they arrive
+	std::future<ProgramSources> m_Loading;
+	bool m_IsLoadForced;
+	// Submitted program that is still compiling, swapped in once complete
+	GLuint m_PendingProgram;
+	std::vector<GLuint> m_PendingShaders;
+	std::vector<GLuint> m_PendingStages;
+	std::vector<GLenum> m_PendingStageTypes;
+	std::unordered_map<std::string, GLenum> m_PendingImageFormats;
+	std::string m_PendingKey;
+	bool m_IsPendingCached;
+	// Why the last submission failed, the previous program is kept meanwhile
+	std::string m_LoadLog;
+	std::string m_ErrorLog;
+	std::string m_FailedKey;
 
 public:
 	Program();
@@ -26,18 +76,49 @@ public:
 	void SetName(const char* name);
 	std::string GetName();
 	GLuint GetProgram();
-	std::vector<std::string> GetShaderFiles();
-	std::vector<GLenum> GetShaderTypes();
+	GLuint GetPipeline();
+	const std::vector<GLuint>& GetStages() const;
+	bool IsLinked();
+	void SetSeparable(bool isSeparable);
+	bool IsSeparable();
+	const std::vector<std::string>& GetShaderFiles() const;
+	const std::vector<GLenum>& GetShaderTypes() const;
+	const std::vector<std::vector<std::string>>& GetSourceFiles() const;
+	bool DependsOn(const std::string& path) const;
+	const std::string& GetErrorLog() const;
 	
-	std::vector<Uniform> GetUniforms();
-	std::vector<UniformBlock> GetUniformBlocks();
-	std::vector<BufferBlock> GetBufferBlocks();
+	const std::vector<Uniform>& GetUniforms() const;
+	const std::vector<ProgramLocation>& GetUniformLocations(const std::string& name) const;
+	const std::vector<UniformBlock>& GetUniformBlocks() const;
+	const std::vector<BufferBlock>& GetBufferBlocks() const;
+	const UniformBlock& GetUniformBlock(int ix) const;
+	const BufferBlock& GetBufferBlock(int ix) const;
+	const std::vector<Spirv::SpecConstant>& GetSpecConstants() const;
+	void SetSpecConstant(const std::string& name, GLuint value);
+	// Format an image uniform is declared with, GL_RGBA8 if it has none
+	GLenum GetImageFormat(const std::string& name) const;
 
 public:
 	void AddShader(const char* file, GLenum type);
 	void RemoveShader(int ix);
 	void SetShaderType(int ix, GLenum type);
-	void Initialize();
+	void Initialize(ThreadPool& workers);
+	void Reload(ThreadPool& workers);
+	bool Poll();
+	bool IsPending();
 	bool NeedsInit();
 	void Destroy();
+
+private:
+	void LoadSources(ThreadPool& workers);
+	void Submit(const ProgramSources& sources, const std::string& key);
+	std::string MakeKey(const ProgramSources& sources);
+	void GetStageConstants(const ProgramSources& sources, int stage,
+		std::vector<GLuint>& ids, std::vector<GLuint>& values);
+	void MergeSpecConstants(const ProgramSources& sources);
+	void DiscardPending();
+	void DeleteLinked();
+	std::string AnnotateLog(const std::string& log, int stage);
+	void Reflect();
+	void ReflectProgram(GLuint program);
 };
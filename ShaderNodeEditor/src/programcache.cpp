@@ -0,0 +1,202 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <direct.h>
+#include <io.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <utime.h>
+#endif
+
+#include "programcache.h"
+
+namespace ProgramCache
+{
+	static const char* CacheDir = "ShaderCache";
+	static const char CacheMagic[4] = { 'S', 'N', 'E', 'B' };
+	// Least recently used binaries are evicted beyond this many entries
+	static const int MaxEntries = 256;
+	// Entries on disk, counted once by the first eviction and kept up to date by Save
+	static int s_NumEntries = -1;
+
+	static void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		// FNV-1a
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	static void HashString(uint64_t& hash, const char* str)
+	{
+		if (str)
+			HashBytes(hash, str, strlen(str) + 1);
+	}
+
+	static std::string EntryPath(const std::string& key)
+	{
+		return std::string(CacheDir) + "/" + key + ".bin";
+	}
+
+	static void ListEntries(std::vector<std::pair<time_t, std::string>>& entries)
+	{
+#if defined(_WIN32)
+		_finddata_t data;
+		intptr_t handle = _findfirst((std::string(CacheDir) + "/*.bin").c_str(), &data);
+		if (handle == -1)
+			return;
+		do
+			entries.push_back({ data.time_write, std::string(CacheDir) + "/" + data.name });
+		while (_findnext(handle, &data) == 0);
+		_findclose(handle);
+#else
+		DIR* dir = opendir(CacheDir);
+		if (!dir)
+			return;
+		while (dirent* entry = readdir(dir))
+		{
+			std::string name = entry->d_name;
+			if (name.size() < 4 || name.substr(name.size() - 4) != ".bin")
+				continue;
+			std::string path = std::string(CacheDir) + "/" + name;
+			struct stat st;
+			if (stat(path.c_str(), &st) == 0)
+				entries.push_back({ st.st_mtime, path });
+		}
+		closedir(dir);
+#endif
+	}
+
+	static void Evict()
+	{
+		std::vector<std::pair<time_t, std::string>> entries;
+		ListEntries(entries);
+		s_NumEntries = entries.size();
+		if (entries.size() <= MaxEntries)
+			return;
+		std::sort(entries.begin(), entries.end());
+		for (int i = 0; i < entries.size() - MaxEntries; i++)
+			remove(entries[i].second.c_str());
+		s_NumEntries = MaxEntries;
+	}
+
+	std::string MakeKey(const std::vector<std::string>& sources, const std::vector<GLenum>& types,
+		bool isSeparable, const std::vector<GLuint>& constants)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		// A binary is only valid for the driver that produced it
+		HashString(hash, (const char*)glGetString(GL_VENDOR));
+		HashString(hash, (const char*)glGetString(GL_RENDERER));
+		HashString(hash, (const char*)glGetString(GL_VERSION));
+		HashBytes(hash, &isSeparable, sizeof(bool));
+		for (int i = 0; i < sources.size(); i++)
+		{
+			HashBytes(hash, &types[i], sizeof(GLenum));
+			HashBytes(hash, sources[i].c_str(), sources[i].size() + 1);
+		}
+		// Specialization constants of SPIR-V modules
+		if (constants.size() > 0)
+			HashBytes(hash, constants.data(), constants.size() * sizeof(GLuint));
+
+		char key[17];
+		snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+		return key;
+	}
+
+	GLuint Load(const std::string& key)
+	{
+		std::string path = EntryPath(key);
+		std::ifstream file(path.c_str(), std::ios::binary);
+		if (!file.is_open())
+			return -1;
+
+		char magic[4];
+		GLenum format = 0;
+		file.read(magic, 4);
+		file.read((char*)&format, sizeof(GLenum));
+		bool isValid = file.good() && memcmp(magic, CacheMagic, 4) == 0;
+		std::vector<char> binary;
+		if (isValid)
+			binary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		isValid = isValid && binary.size() > 0;
+		file.close();
+		if (!isValid)
+		{
+			remove(path.c_str());
+			return -1;
+		}
+
+		GLuint program = glCreateProgram();
+		glProgramBinary(program, format, binary.data(), binary.size());
+		GLint status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status != GL_TRUE)
+		{
+			// Stale after a driver update, it is replaced once the program is rebuilt
+			glDeleteProgram(program);
+			remove(path.c_str());
+			return -1;
+		}
+
+		// Mark as recently used for eviction
+#if defined(_WIN32)
+		_utime(path.c_str(), NULL);
+#else
+		utime(path.c_str(), NULL);
+#endif
+		return program;
+	}
+
+	void Save(const std::string& key, GLuint program)
+	{
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		GLint status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (numFormats == 0 || status != GL_TRUE)
+			return;
+
+		GLint size = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+		if (size <= 0)
+			return;
+		std::vector<char> binary(size);
+		GLenum format = 0;
+		glGetProgramBinary(program, size, NULL, &format, binary.data());
+
+#if defined(_WIN32)
+		_mkdir(CacheDir);
+#else
+		mkdir(CacheDir, 0755);
+#endif
+		// The directory is only listed on the first save and when the budget is exceeded
+		if (s_NumEntries == -1)
+			Evict();
+		struct stat st;
+		bool isNew = stat(EntryPath(key).c_str(), &st) != 0;
+		std::ofstream file(EntryPath(key).c_str(), std::ios::binary);
+		if (!file.is_open())
+			return;
+		file.write(CacheMagic, 4);
+		file.write((const char*)&format, sizeof(GLenum));
+		file.write(binary.data(), binary.size());
+		file.close();
+
+		if (isNew)
+			s_NumEntries++;
+		if (s_NumEntries > MaxEntries)
+			Evict();
+	}
+}
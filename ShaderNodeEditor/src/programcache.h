@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Linked program binaries stored on disk, keyed by a hash of the expanded
+// shader sources, the stage list and the driver that produced them
+namespace ProgramCache
+{
+	std::string MakeKey(const std::vector<std::string>& sources, const std::vector<GLenum>& types,
+		bool isSeparable = false, const std::vector<GLuint>& constants = std::vector<GLuint>());
+	// Returns -1 on a miss or if the driver rejects the cached binary
+	GLuint Load(const std::string& key);
+	void Save(const std::string& key, GLuint program);
+}
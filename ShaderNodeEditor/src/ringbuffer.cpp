@@ -0,0 +1,110 @@
+#include "ringbuffer.h"
+
+RingBuffer::RingBuffer(GLenum target, int numSegments) :
+	m_Target(target),
+	m_Buffer(-1),
+	m_Data(0),
+	m_NumSegments(numSegments),
+	m_SegmentSize(0),
+	m_Alignment(0),
+	m_Segment(0),
+	m_Head(0),
+	m_Fences(numSegments, (GLsync)0)
+{
+}
+
+RingBuffer::~RingBuffer()
+{
+	Destroy();
+}
+
+GLuint RingBuffer::GetBuffer()
+{
+	return m_Buffer;
+}
+
+GLsizeiptr RingBuffer::Align(GLsizeiptr size)
+{
+	if (m_Alignment == 0)
+	{
+		GLenum alignment = m_Target == GL_SHADER_STORAGE_BUFFER ?
+			GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT : GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT;
+		glGetIntegerv(alignment, &m_Alignment);
+		if (m_Alignment < 1)
+			m_Alignment = 1;
+	}
+	return (size + m_Alignment - 1) / m_Alignment * m_Alignment;
+}
+
+void RingBuffer::Reserve(GLsizeiptr size)
+{
+	if (m_Buffer != -1 && size <= m_SegmentSize)
+		return;
+
+	Destroy();
+
+	m_SegmentSize = Align(size > 65536 ? size : 65536);
+	GLsizeiptr totalSize = m_SegmentSize * m_NumSegments;
+	glCreateBuffers(1, &m_Buffer);
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glNamedBufferStorage(m_Buffer, totalSize, NULL, flags);
+	m_Data = (GLubyte*)glMapNamedBufferRange(m_Buffer, 0, totalSize, flags);
+
+	m_Segment = 0;
+	m_Head = 0;
+}
+
+void RingBuffer::BeginFrame()
+{
+	WaitFence(m_Segment);
+	m_Head = 0;
+}
+
+GLintptr RingBuffer::Allocate(GLsizeiptr size, GLubyte** data)
+{
+	if (!m_Data || size <= 0 || m_Head + size > m_SegmentSize)
+		return -1;
+
+	GLintptr offset = m_SegmentSize * m_Segment + m_Head;
+	m_Head = Align(m_Head + size);
+	*data = m_Data + offset;
+	return offset;
+}
+
+void RingBuffer::EndFrame()
+{
+	if (m_Buffer == -1)
+		return;
+	m_Fences[m_Segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_Segment = (m_Segment + 1) % m_NumSegments;
+	m_Head = 0;
+}
+
+void RingBuffer::Destroy()
+{
+	if (m_Buffer == -1)
+		return;
+
+	for (int i = 0; i < m_NumSegments; i++)
+		WaitFence(i);
+	glUnmapNamedBuffer(m_Buffer);
+	glDeleteBuffers(1, &m_Buffer);
+	m_Buffer = -1;
+	m_Data = 0;
+	m_SegmentSize = 0;
+}
+
+void RingBuffer::WaitFence(int segment)
+{
+	GLsync fence = m_Fences[segment];
+	if (!fence)
+		return;
+	while (true)
+	{
+		GLenum res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		if (res != GL_TIMEOUT_EXPIRED)
+			break;
+	}
+	glDeleteSync(fence);
+	m_Fences[segment] = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+// A persistently mapped buffer split into one segment per frame in flight.
+// Each frame sub-allocates from its own segment and fences it at the end,
+// the segment is only written again once the GPU has passed that fence.
+class RingBuffer
+{
+private:
+	GLenum m_Target;
+	GLuint m_Buffer;
+	GLubyte* m_Data;
+
+	int m_NumSegments;
+	GLsizeiptr m_SegmentSize;
+	GLint m_Alignment;
+	int m_Segment;
+	GLsizeiptr m_Head;
+	std::vector<GLsync> m_Fences;
+
+public:
+	RingBuffer(GLenum target, int numSegments = 3);
+	~RingBuffer();
+
+public:
+	GLuint GetBuffer();
+	GLsizeiptr Align(GLsizeiptr size);
+
+public:
+	void Reserve(GLsizeiptr size);
+	void BeginFrame();
+	// Returns the offset of the allocation in the buffer, or -1 if the frame is full
+	GLintptr Allocate(GLsizeiptr size, GLubyte** data);
+	void EndFrame();
+	void Destroy();
+
+private:
+	void WaitFence(int segment);
+};
@@ -5,8 +5,7 @@
 
 #include <GL/glew.h>
 
-#include "Shadinclude.hpp"
-
+#include "spirv.h"
 #include "shaders.h"
 
 std::string FindFile(const std::string& strFilename)
@@ -18,46 +17,133 @@ std::string FindFile(const std::string& strFilename)
 		return std::string();
 }
 
-std::string LoadShader(const std::string& strShaderFilename)
+std::string LoadShaderModule(const std::string& strModuleFilename)
 {
-	/*std::string strFilename = FindFile(strShaderFilename);
-	std::ifstream shaderFile(strFilename.c_str());
-	std::stringstream shaderData;
-	shaderData << shaderFile.rdbuf();
-	shaderFile.close();
-
-	return shaderData.str();*/
-	return Shadinclude::load(strShaderFilename);
+	// Empty if the file can't be read, the caller reports it
+	std::ifstream moduleFile(strModuleFilename.c_str(), std::ios::binary);
+	if (!moduleFile.is_open())
+		return std::string();
+	std::stringstream moduleData;
+	moduleData << moduleFile.rdbuf();
+	return moduleData.str();
 }
 
-GLuint CreateShader(GLenum eShaderType, const std::string& strShader)
+GLuint CreateShader(GLenum eShaderType, const std::string& strShader,
+	const std::vector<GLuint>& constantIds, const std::vector<GLuint>& constantValues)
 {
+	if (Spirv::IsModule(strShader))
+		return CreateSpirvShader(eShaderType, strShader, constantIds, constantValues);
+
 	GLuint shader = glCreateShader(eShaderType);
 	const char* strData = strShader.c_str();
 	glShaderSource(shader, 1, &strData, NULL);
 
+	// The status is not queried here, so the driver can keep compiling in the background
 	glCompileShader(shader);
 
-	GLint status;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	return shader;
+}
+
+bool IsSpirvSupported()
+{
+	return GLEW_VERSION_4_6 || GLEW_ARB_gl_spirv;
+}
+
+GLuint CreateSpirvShader(GLenum eShaderType, const std::string& strModule,
+	const std::vector<GLuint>& constantIds, const std::vector<GLuint>& constantValues)
+{
+	// Precompiled modules skip the GLSL front end, only specialization is left to the driver
+	GLuint shader = glCreateShader(eShaderType);
+	if (GLEW_VERSION_4_6)
+	{
+		glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V, strModule.data(), (GLsizei)strModule.size());
+		glSpecializeShader(shader, "main", (GLuint)constantIds.size(), constantIds.data(), constantValues.data());
+	}
+	else if (GLEW_ARB_gl_spirv)
+	{
+		glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, strModule.data(), (GLsizei)strModule.size());
+		glSpecializeShaderARB(shader, "main", (GLuint)constantIds.size(), constantIds.data(), constantValues.data());
+	}
 
 	return shader;
 }
 
-GLuint CreateProgram(const std::vector<GLuint>& shaderList)
+GLuint CreateProgram(const std::vector<GLuint>& shaderList, bool isSeparable)
 {
 	GLuint program = glCreateProgram();
 
 	for (size_t iLoop = 0; iLoop < shaderList.size(); iLoop++)
 		glAttachShader(program, shaderList[iLoop]);
 
+	// Allows the linked binary to be stored in the program cache
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	if (isSeparable)
+		glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
 	glLinkProgram(program);
 
-	GLint status;
-	glGetProgramiv(program, GL_LINK_STATUS, &status);
-
 	for (size_t iLoop = 0; iLoop < shaderList.size(); iLoop++)
 		glDetachShader(program, shaderList[iLoop]);
 
 	return program;
 }
+
+void EnableParallelShaderCompile()
+{
+	// Let the driver pick the number of compiler threads
+	if (GLEW_KHR_parallel_shader_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	else if (GLEW_ARB_parallel_shader_compile)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+}
+
+bool IsProgramComplete(GLuint program)
+{
+	// Without the extension, the first status query blocks until the link is done
+	if (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile)
+		return true;
+
+	GLint complete = GL_FALSE;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+std::string GetShaderLog(GLuint shader)
+{
+	GLint length = 0;
+	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+	if (length <= 1)
+		return std::string();
+	std::string log(length, '\0');
+	glGetShaderInfoLog(shader, length, NULL, &log[0]);
+	log.resize(length - 1);
+	return log;
+}
+
+std::string GetProgramLog(GLuint program)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+	if (length <= 1)
+		return std::string();
+	std::string log(length, '\0');
+	glGetProgramInfoLog(program, length, NULL, &log[0]);
+	log.resize(length - 1);
+	return log;
+}
+
+GLbitfield ShaderStageBit(GLenum eShaderType)
+{
+	if (eShaderType == GL_VERTEX_SHADER)
+		return GL_VERTEX_SHADER_BIT;
+	else if (eShaderType == GL_TESS_CONTROL_SHADER)
+		return GL_TESS_CONTROL_SHADER_BIT;
+	else if (eShaderType == GL_TESS_EVALUATION_SHADER)
+		return GL_TESS_EVALUATION_SHADER_BIT;
+	else if (eShaderType == GL_GEOMETRY_SHADER)
+		return GL_GEOMETRY_SHADER_BIT;
+	else if (eShaderType == GL_FRAGMENT_SHADER)
+		return GL_FRAGMENT_SHADER_BIT;
+	else if (eShaderType == GL_COMPUTE_SHADER)
+		return GL_COMPUTE_SHADER_BIT;
+	return 0;
+}
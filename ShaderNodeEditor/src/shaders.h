@@ -1,8 +1,18 @@
 #ifndef __shaders_h__
 #define __shaders_h__
 
-std::string LoadShader(const std::string& strShaderFilename);
-GLuint CreateShader(GLenum eShaderType, const std::string& strShaderFile);
-GLuint CreateProgram(const std::vector<GLuint>& shaderList);
+std::string LoadShaderModule(const std::string& strModuleFilename);
+GLuint CreateShader(GLenum eShaderType, const std::string& strShaderFile,
+	const std::vector<GLuint>& constantIds = std::vector<GLuint>(),
+	const std::vector<GLuint>& constantValues = std::vector<GLuint>());
+bool IsSpirvSupported();
+GLuint CreateSpirvShader(GLenum eShaderType, const std::string& strModule,
+	const std::vector<GLuint>& constantIds, const std::vector<GLuint>& constantValues);
+GLuint CreateProgram(const std::vector<GLuint>& shaderList, bool isSeparable = false);
+GLbitfield ShaderStageBit(GLenum eShaderType);
+void EnableParallelShaderCompile();
+bool IsProgramComplete(GLuint program);
+std::string GetShaderLog(GLuint shader);
+std::string GetProgramLog(GLuint program);
 
 #endif
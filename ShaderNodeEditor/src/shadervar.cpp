@@ -3,14 +3,20 @@
 ShaderVar::ShaderVar() :
 	m_Name(""),
 	m_Type(GL_BOOL),
-	m_ArraySize(1)
+	m_ArraySize(1),
+	m_Offset(-1),
+	m_ArrayStride(0),
+	m_MatrixStride(0)
 {
 }
 
 ShaderVar::ShaderVar(GLenum type, const char* name) :
 	m_Name(name),
 	m_Type(type),
-	m_ArraySize(1)
+	m_ArraySize(1),
+	m_Offset(-1),
+	m_ArrayStride(0),
+	m_MatrixStride(0)
 {
 	if (m_Name[m_Name.size() - 1] == ']')
 		m_Name = m_Name.substr(0, m_Name.find_last_of('['));
@@ -19,7 +25,10 @@ ShaderVar::ShaderVar(GLenum type, const char* name) :
 ShaderVar::ShaderVar(GLenum type, const char* name, int size) :
 	m_Name(name),
 	m_Type(type),
-	m_ArraySize(size)
+	m_ArraySize(size),
+	m_Offset(-1),
+	m_ArrayStride(0),
+	m_MatrixStride(0)
 {
 	if (m_Name[m_Name.size() - 1] == ']')
 		m_Name = m_Name.substr(0, m_Name.find_last_of('['));
@@ -36,7 +45,7 @@ void ShaderVar::SetName(const char* name)
 		m_Name = m_Name.substr(0, m_Name.find_last_of('['));
 }
 
-std::string ShaderVar::GetName()
+const std::string& ShaderVar::GetName() const
 {
 	return m_Name;
 }
@@ -46,7 +55,7 @@ void ShaderVar::SetType(GLenum type)
 	m_Type = type;
 }
 
-GLenum ShaderVar::GetType()
+GLenum ShaderVar::GetType() const
 {
 	return m_Type;
 }
@@ -56,7 +65,30 @@ void ShaderVar::SetArraySize(int size)
 	m_ArraySize = size;
 }
 
-int ShaderVar::ArraySize()
+int ShaderVar::ArraySize() const
 {
 	return m_ArraySize;
 }
+
+
+void ShaderVar::SetLayout(int offset, int arrayStride, int matrixStride)
+{
+	m_Offset = offset;
+	m_ArrayStride = arrayStride;
+	m_MatrixStride = matrixStride;
+}
+
+int ShaderVar::GetOffset() const
+{
+	return m_Offset;
+}
+
+int ShaderVar::GetArrayStride() const
+{
+	return m_ArrayStride;
+}
+
+int ShaderVar::GetMatrixStride() const
+{
+	return m_MatrixStride;
+}
\ No newline at end of file
@@ -5,12 +5,24 @@
 
 #include <GL/glew.h>
 
+// A uniform location or block index within one GL program. A separable
+// program declares the same uniform or block in every stage that uses it
+struct ProgramLocation
+{
+	GLuint program;
+	int index;
+};
+
 class ShaderVar
 {
 protected:
 	std::string m_Name;
 	GLenum m_Type;
 	int m_ArraySize;
+	// Layout inside the owning block, as reflected from the linked program
+	int m_Offset;
+	int m_ArrayStride;
+	int m_MatrixStride;
 
 public:
 	ShaderVar();
@@ -20,9 +32,13 @@ public:
 
 public:
 	void SetName(const char* name);
-	std::string GetName();
+	const std::string& GetName() const;
 	void SetType(GLenum type);
-	GLenum GetType();
+	GLenum GetType() const;
 	void SetArraySize(int size);
-	int ArraySize();
+	int ArraySize() const;
+	void SetLayout(int offset, int arrayStride, int matrixStride);
+	int GetOffset() const;
+	int GetArrayStride() const;
+	int GetMatrixStride() const;
 };
\ No newline at end of file
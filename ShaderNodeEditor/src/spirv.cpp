@@ -0,0 +1,87 @@
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+#include "spirv.h"
+
+namespace Spirv
+{
+	static const uint32_t Magic = 0x07230203;
+	static const int HeaderWords = 5;
+
+	static const uint32_t OpName = 5;
+	static const uint32_t OpTypeBool = 20;
+	static const uint32_t OpTypeInt = 21;
+	static const uint32_t OpTypeFloat = 22;
+	static const uint32_t OpSpecConstantTrue = 48;
+	static const uint32_t OpSpecConstantFalse = 49;
+	static const uint32_t OpSpecConstant = 50;
+	static const uint32_t OpDecorate = 71;
+	static const uint32_t DecorationSpecId = 1;
+
+	bool IsModule(const std::string& code)
+	{
+		uint32_t magic = 0;
+		if (code.size() < HeaderWords * 4 || code.size() % 4 != 0)
+			return false;
+		memcpy(&magic, code.data(), 4);
+		return magic == Magic;
+	}
+
+	void GetSpecConstants(const std::string& code, std::vector<SpecConstant>& constants)
+	{
+		if (!IsModule(code))
+			return;
+		std::vector<uint32_t> words(code.size() / 4);
+		memcpy(words.data(), code.data(), code.size());
+
+		std::unordered_map<uint32_t, std::string> names;
+		std::unordered_map<uint32_t, uint32_t> specIds;
+		std::unordered_map<uint32_t, GLenum> types;
+		for (size_t i = HeaderWords; i < words.size();)
+		{
+			uint32_t opcode = words[i] & 0xFFFF;
+			uint32_t count = words[i] >> 16;
+			if (count == 0 || i + count > words.size())
+				break;
+			const uint32_t* args = &words[i + 1];
+
+			if (opcode == OpName && count > 2)
+			{
+				const char* str = (const char*)&args[1];
+				size_t maxLength = (count - 2) * 4;
+				const char* end = (const char*)memchr(str, 0, maxLength);
+				names[args[0]] = std::string(str, end ? end - str : maxLength);
+			}
+			else if (opcode == OpDecorate && count > 3 && args[1] == DecorationSpecId)
+				specIds[args[0]] = args[2];
+			else if (opcode == OpTypeBool)
+				types[args[0]] = GL_BOOL;
+			else if (opcode == OpTypeInt && count > 3)
+				types[args[0]] = args[1] != 32 ? GL_NONE : (args[2] ? GL_INT : GL_UNSIGNED_INT);
+			else if (opcode == OpTypeFloat && count > 2)
+				types[args[0]] = args[1] != 32 ? GL_NONE : GL_FLOAT;
+			else if ((opcode == OpSpecConstantTrue || opcode == OpSpecConstantFalse ||
+				opcode == OpSpecConstant) && count > 2)
+			{
+				auto specId = specIds.find(args[1]);
+				GLenum type = types.count(args[0]) ? types[args[0]] : GL_NONE;
+				// glSpecializeShader only takes 32 bit values
+				if (specId != specIds.end() && type != GL_NONE)
+				{
+					SpecConstant constant;
+					constant.id = specId->second;
+					constant.type = type;
+					if (opcode == OpSpecConstant && count > 3)
+						constant.value = args[2];
+					else
+						constant.value = opcode == OpSpecConstantTrue ? 1 : 0;
+					constant.name = names.count(args[1]) && !names[args[1]].empty() ?
+						names[args[1]] : "constant_id " + std::to_string(constant.id);
+					constants.push_back(constant);
+				}
+			}
+			i += count;
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Minimal reader for precompiled SPIR-V modules, enough to find the
+// specialization constants a module can be specialized with
+namespace Spirv
+{
+	struct SpecConstant
+	{
+		std::string name;
+		GLuint id = 0;
+		GLenum type = GL_INT; // GL_BOOL, GL_INT, GL_UNSIGNED_INT or GL_FLOAT
+		GLuint value = 0; // Raw 32 bits, as passed to glSpecializeShader
+	};
+
+	bool IsModule(const std::string& code);
+	void GetSpecConstants(const std::string& code, std::vector<SpecConstant>& constants);
+}
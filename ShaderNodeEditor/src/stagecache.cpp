@@ -0,0 +1,94 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+#include "shaders.h"
+#include "programcache.h"
+#include "stagecache.h"
+
+namespace StageCache
+{
+	struct Stage
+	{
+		std::string key;
+		GLuint shader = -1; // Kept for its info log, -1 if loaded from the program cache
+		int refs = 0;
+		bool isSaved = false;
+	};
+
+	static std::unordered_map<std::string, GLuint> s_Keys;
+	static std::unordered_map<GLuint, Stage> s_Stages;
+
+	GLuint Acquire(const std::string& key, GLenum type, const std::string& source,
+		const std::vector<GLuint>& constantIds, const std::vector<GLuint>& constantValues)
+	{
+		auto found = s_Keys.find(key);
+		if (found != s_Keys.end())
+		{
+			s_Stages[found->second].refs++;
+			return found->second;
+		}
+
+		Stage stage;
+		stage.key = key;
+		stage.refs = 1;
+		GLuint program = ProgramCache::Load(key);
+		stage.isSaved = program != -1;
+		if (program == -1)
+		{
+			stage.shader = CreateShader(type, source, constantIds, constantValues);
+			program = CreateProgram({ stage.shader }, true);
+		}
+		s_Keys[key] = program;
+		s_Stages[program] = stage;
+		return program;
+	}
+
+	void Release(GLuint stage)
+	{
+		auto found = s_Stages.find(stage);
+		if (found == s_Stages.end() || --found->second.refs > 0)
+			return;
+		if (found->second.shader != -1)
+			glDeleteShader(found->second.shader);
+		glDeleteProgram(stage);
+		s_Keys.erase(found->second.key);
+		s_Stages.erase(found);
+	}
+
+	bool IsComplete(GLuint stage)
+	{
+		if (!IsProgramComplete(stage))
+			return false;
+		Stage& entry = s_Stages[stage];
+		if (!entry.isSaved)
+		{
+			ProgramCache::Save(entry.key, stage);
+			entry.isSaved = true;
+		}
+		return true;
+	}
+
+	bool IsLinked(GLuint stage)
+	{
+		GLint status = GL_FALSE;
+		glGetProgramiv(stage, GL_LINK_STATUS, &status);
+		return status == GL_TRUE;
+	}
+
+	std::string GetLog(GLuint stage)
+	{
+		std::string log;
+		auto found = s_Stages.find(stage);
+		if (found != s_Stages.end() && found->second.shader != -1)
+			log += GetShaderLog(found->second.shader);
+		return log + GetProgramLog(stage);
+	}
+
+	int NumStages()
+	{
+		return s_Stages.size();
+	}
+}
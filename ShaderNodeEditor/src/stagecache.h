@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Separable single-stage programs shared by every program built from the
+// same stage source, so a common vertex shader is compiled once. Binaries
+// go through the program cache like whole programs. GL thread only
+namespace StageCache
+{
+	// Returns the stage program for the key, compiling it if no program holds it yet
+	GLuint Acquire(const std::string& key, GLenum type, const std::string& source,
+		const std::vector<GLuint>& constantIds, const std::vector<GLuint>& constantValues);
+	void Release(GLuint stage);
+	// Polls without blocking, a stage that compiled is saved to the program cache once
+	bool IsComplete(GLuint stage);
+	bool IsLinked(GLuint stage);
+	std::string GetLog(GLuint stage);
+	int NumStages();
+}
@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <exception>
+
 #include "texture.h"
 
+#include "textureuploader.h"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
@@ -8,7 +13,19 @@ Texture::Texture() :
 	m_Path(""),
 	m_Texture(-1),
 	m_Width(0),
-	m_Height(0)
+	m_Height(0),
+	m_FileSize(0),
+	m_FileHash(0),
+	m_ErrorLog(""),
+	m_IsLoadQueued(false),
+	m_NeedsReload(false),
+	m_Workers(0),
+	m_PendingTexture(-1),
+	m_PendingSize{},
+	m_PendingFileSize(0),
+	m_PendingFileHash(0),
+	m_IsPendingMipmapped(false),
+	m_Uploader(0)
 {
 }
 
@@ -17,9 +34,20 @@ Texture::Texture(const char* path) :
 	m_Path(path),
 	m_Texture(-1),
 	m_Width(0),
-	m_Height(0)
+	m_Height(0),
+	m_FileSize(0),
+	m_FileHash(0),
+	m_ErrorLog(""),
+	m_IsLoadQueued(false),
+	m_NeedsReload(false),
+	m_Workers(0),
+	m_PendingTexture(-1),
+	m_PendingSize{},
+	m_PendingFileSize(0),
+	m_PendingFileHash(0),
+	m_IsPendingMipmapped(false),
+	m_Uploader(0)
 {
-	LoadFromFile(path);
 	std::string name = path;
 	name = name.substr(name.find_last_of('/') + 1);
 	m_Name = name.substr(0, name.find_last_of('.'));
@@ -53,32 +81,158 @@ void Texture::GetSize(int* width, int* height)
 
 GLuint Texture::GetTexture()
 {
+	if (m_Texture == -1 && m_Uploader)
+		return m_Uploader->GetPlaceholder();
 	return m_Texture;
 }
 
-void Texture::LoadFromFile(const char* path)
+bool Texture::IsLoading()
+{
+	return m_IsLoadQueued || m_Loading.valid() || m_PendingTexture != -1;
+}
+
+std::string Texture::GetErrorLog()
+{
+	return m_ErrorLog;
+}
+
+void Texture::Load(ThreadPool& workers, TextureUploader& uploader)
 {
-	int n;
-	auto data = stbi_load(path, &m_Width, &m_Height, &n, 4);
+	// Replaces a load in flight, its result is dropped. The decode itself
+	// starts once the uploader has room for it
+	DiscardPending();
+	m_Uploader = &uploader;
+	m_Workers = &workers;
+	m_IsLoadQueued = true;
+	m_NeedsReload = false;
+}
 
-	if (m_Texture == -1)
-		glGenTextures(1, &m_Texture);
-	glBindTexture(GL_TEXTURE_2D, m_Texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_Width, m_Height, 0,
-		GL_RGBA, GL_UNSIGNED_BYTE, data);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
+void Texture::StartDecode()
+{
+	m_IsLoadQueued = false;
+	m_Uploader->BeginDecode();
+	std::string path = m_Path;
+	m_Loading = m_Workers->Submit<std::shared_ptr<const TextureData>>([path]()
+	{
+		// A failed allocation on a hostile file is a failed load, not an exception in Poll
+		try
+		{
+			return ImageCache::Decode(path);
+		}
+		catch (const std::exception& e)
+		{
+			auto result = std::make_shared<TextureData>();
+			result->log = "ERROR: could not load the texture at: " + path + " (" + e.what() + ")\n";
+			return std::shared_ptr<const TextureData>(result);
+		}
+	});
+}
 
-	stbi_image_free(data);
+void Texture::Reload(ThreadPool& workers, TextureUploader& uploader)
+{
+	// A load in flight may have read the file before it changed, so the reload
+	// waits for it instead of being dropped. Whether the file changed is only
+	// known on the worker, unchanged files come back from the image cache and
+	// are not uploaded again
+	if (m_IsLoadQueued)
+		return;
+	if (IsLoading())
+	{
+		m_NeedsReload = true;
+		return;
+	}
+	Load(workers, uploader);
+}
 
-	m_Path = path;
+bool Texture::Poll()
+{
+	if (m_IsLoadQueued && m_Uploader->CanDecode())
+		StartDecode();
+
+	// Decoded images are given storage here, on the GL thread, and streamed by the uploader
+	if (m_Loading.valid() && m_Loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		std::shared_ptr<const TextureData> data = m_Loading.get();
+		m_Uploader->EndDecode();
+		m_ErrorLog = data->log;
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		// The GPU copy is immutable, an unchanged file keeps it as it is
+		bool isUnchanged = m_Texture != -1 && data->fileSize == m_FileSize && data->fileHash == m_FileHash;
+		if (!data->pixels.empty() && (data->width > maxSize || data->height > maxSize))
+			m_ErrorLog = "ERROR: the texture at: " + m_Path + " is larger than GL_MAX_TEXTURE_SIZE\n";
+		else if (!data->pixels.empty() && !isUnchanged)
+		{
+			// Full mip chain, the levels below the base are generated once the upload completes.
+			// Compressed files bring their own levels, which are uploaded as they are.
+			// These parameters are the defaults, sampler nodes override them
+			int levels = data->levels.size();
+			m_IsPendingMipmapped = levels > 1 || data->isCompressed;
+			while (!m_IsPendingMipmapped && (std::max(data->width, data->height) >> levels) > 0)
+				levels++;
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_PendingTexture);
+			glTextureStorage2D(m_PendingTexture, levels, data->format, data->width, data->height);
+			glTextureParameteri(m_PendingTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTextureParameteri(m_PendingTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTextureParameteri(m_PendingTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTextureParameteri(m_PendingTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			// Grey images sample as grey, not red, as they did when expanded to RGBA
+			if (!data->isCompressed && data->pixelFormat == GL_RED)
+			{
+				const GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+				glTextureParameteriv(m_PendingTexture, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+			}
+			else if (!data->isCompressed && data->pixelFormat == GL_RG)
+			{
+				const GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+				glTextureParameteriv(m_PendingTexture, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+			}
+			m_PendingSize[0] = data->width;
+			m_PendingSize[1] = data->height;
+			m_PendingFileSize = data->fileSize;
+			m_PendingFileHash = data->fileHash;
+			m_Uploader->Queue(m_PendingTexture, data);
+		}
+	}
+
+	if (m_NeedsReload && !m_Loading.valid() && m_PendingTexture == -1)
+		Load(*m_Workers, *m_Uploader);
+
+	// The current texture stays in use until the new one is fully uploaded
+	if (m_PendingTexture == -1 || m_Uploader->IsUploading(m_PendingTexture))
+		return false;
+	if (!m_IsPendingMipmapped)
+		glGenerateTextureMipmap(m_PendingTexture);
+	if (m_Texture != -1)
+		glDeleteTextures(1, &m_Texture);
+	m_Texture = m_PendingTexture;
+	m_Width = m_PendingSize[0];
+	m_Height = m_PendingSize[1];
+	m_FileSize = m_PendingFileSize;
+	m_FileHash = m_PendingFileHash;
+	m_PendingTexture = -1;
+	return true;
+}
+
+void Texture::DiscardPending()
+{
+	m_IsLoadQueued = false;
+	if (m_Loading.valid())
+	{
+		m_Uploader->EndDecode();
+		m_Loading = std::future<std::shared_ptr<const TextureData>>();
+	}
+	if (m_PendingTexture != -1)
+	{
+		m_Uploader->Cancel(m_PendingTexture);
+		glDeleteTextures(1, &m_PendingTexture);
+		m_PendingTexture = -1;
+	}
 }
 
 void Texture::Destroy()
 {
+	DiscardPending();
 	if (m_Texture != -1)
 	{
 		glDeleteTextures(1, &m_Texture);
@@ -86,5 +240,8 @@ void Texture::Destroy()
 	}
 	m_Width = 0;
 	m_Height = 0;
+	m_FileSize = 0;
+	m_FileHash = 0;
+	m_NeedsReload = false;
 	m_Path = "";
 }
@@ -1,9 +1,17 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <memory>
+#include <future>
 
 #include <GL/glew.h>
 
+#include "threadpool.h"
+#include "imagecache.h"
+
+class TextureUploader;
+
 class Texture
 {
 private:
@@ -12,6 +20,28 @@ private:
 	GLuint m_Texture;
 	int m_Width;
 	int m_Height;
+	// Size and content hash of the file the texture was uploaded from
+	unsigned long long m_FileSize;
+	unsigned long long m_FileHash;
+
+	// Log of the last load, empty if it succeeded
+	std::string m_ErrorLog;
+
+	// Load waiting for the uploader to allow another decode
+	bool m_IsLoadQueued;
+	// Reload asked for while a load was in flight, started once it is done
+	bool m_NeedsReload;
+	ThreadPool* m_Workers;
+	// Image still being decoded by a worker
+	std::future<std::shared_ptr<const TextureData>> m_Loading;
+	// Texture being streamed by the uploader, swapped in once complete
+	GLuint m_PendingTexture;
+	int m_PendingSize[2];
+	unsigned long long m_PendingFileSize;
+	unsigned long long m_PendingFileHash;
+	// The pending texture already has all its levels, nothing to generate
+	bool m_IsPendingMipmapped;
+	TextureUploader* m_Uploader;
 
 public:
 	Texture();
@@ -23,9 +53,19 @@ public:
 	std::string GetName();
 	std::string GetPath();
 	void GetSize(int* width, int* height);
+	// The uploader's placeholder until the first load completes
 	GLuint GetTexture();
+	bool IsLoading();
+	std::string GetErrorLog();
 
 public:
-	void LoadFromFile(const char* path);
+	void Load(ThreadPool& workers, TextureUploader& uploader);
+	// Uploads again only if the file changed since the texture was uploaded
+	void Reload(ThreadPool& workers, TextureUploader& uploader);
+	bool Poll();
 	void Destroy();
+
+private:
+	void StartDecode();
+	void DiscardPending();
 };
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cstring>
+
+#include "pathutil.h"
+#include "texturecontainer.h"
+
+namespace TextureContainer
+{
+	static unsigned int ReadU32(const std::string& file, size_t offset)
+	{
+		unsigned int value = 0;
+		if (offset + 4 <= file.size())
+			memcpy(&value, file.data() + offset, 4);
+		return value;
+	}
+
+	static unsigned long long ReadU64(const std::string& file, size_t offset)
+	{
+		unsigned long long value = 0;
+		if (offset + 8 <= file.size())
+			memcpy(&value, file.data() + offset, 8);
+		return value;
+	}
+
+	static int BlockSize(GLenum format)
+	{
+		if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT ||
+			format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT ||
+			format == GL_COMPRESSED_RED_RGTC1 || format == GL_COMPRESSED_SIGNED_RED_RGTC1)
+			return 8;
+		return 16;
+	}
+
+	static GLenum FourCCToFormat(unsigned int fourCC)
+	{
+		char code[5]{};
+		memcpy(code, &fourCC, 4);
+		std::string str = code;
+		if (str == "DXT1")
+			return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		else if (str == "DXT3")
+			return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+		else if (str == "DXT5")
+			return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		else if (str == "ATI1" || str == "BC4U")
+			return GL_COMPRESSED_RED_RGTC1;
+		else if (str == "BC4S")
+			return GL_COMPRESSED_SIGNED_RED_RGTC1;
+		else if (str == "ATI2" || str == "BC5U")
+			return GL_COMPRESSED_RG_RGTC2;
+		else if (str == "BC5S")
+			return GL_COMPRESSED_SIGNED_RG_RGTC2;
+		return 0;
+	}
+
+	static GLenum DxgiToFormat(unsigned int dxgiFormat)
+	{
+		if (dxgiFormat == 71) return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		else if (dxgiFormat == 72) return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+		else if (dxgiFormat == 74) return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+		else if (dxgiFormat == 75) return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+		else if (dxgiFormat == 77) return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		else if (dxgiFormat == 78) return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+		else if (dxgiFormat == 80) return GL_COMPRESSED_RED_RGTC1;
+		else if (dxgiFormat == 81) return GL_COMPRESSED_SIGNED_RED_RGTC1;
+		else if (dxgiFormat == 83) return GL_COMPRESSED_RG_RGTC2;
+		else if (dxgiFormat == 84) return GL_COMPRESSED_SIGNED_RG_RGTC2;
+		else if (dxgiFormat == 95) return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+		else if (dxgiFormat == 96) return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+		else if (dxgiFormat == 98) return GL_COMPRESSED_RGBA_BPTC_UNORM;
+		else if (dxgiFormat == 99) return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+		return 0;
+	}
+
+	static GLenum VkToFormat(unsigned int vkFormat)
+	{
+		if (vkFormat == 131) return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		else if (vkFormat == 132) return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+		else if (vkFormat == 133) return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		else if (vkFormat == 134) return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+		else if (vkFormat == 135) return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+		else if (vkFormat == 136) return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+		else if (vkFormat == 137) return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		else if (vkFormat == 138) return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+		else if (vkFormat == 139) return GL_COMPRESSED_RED_RGTC1;
+		else if (vkFormat == 140) return GL_COMPRESSED_SIGNED_RED_RGTC1;
+		else if (vkFormat == 141) return GL_COMPRESSED_RG_RGTC2;
+		else if (vkFormat == 142) return GL_COMPRESSED_SIGNED_RG_RGTC2;
+		else if (vkFormat == 143) return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+		else if (vkFormat == 144) return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+		else if (vkFormat == 145) return GL_COMPRESSED_RGBA_BPTC_UNORM;
+		else if (vkFormat == 146) return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+		return 0;
+	}
+
+	static size_t LevelSize(GLenum format, int width, int height)
+	{
+		return (size_t)BlockSize(format) * ((width + 3) / 4) * ((height + 3) / 4);
+	}
+
+	// GL 4.5 guarantees at least this GL_MAX_TEXTURE_SIZE, the driver's own limit is
+	// checked again on the GL thread before storage is created
+	static const int MaxSize = 16384;
+
+	static bool IsValidSize(TextureData& data)
+	{
+		if (data.width <= 0 || data.height <= 0 || data.width > MaxSize || data.height > MaxSize)
+		{
+			data.log = "invalid texture size " + std::to_string(data.width) + "x" + std::to_string(data.height);
+			return false;
+		}
+		return true;
+	}
+
+	static int MaxLevels(const TextureData& data)
+	{
+		int levels = 1;
+		while ((std::max(data.width, data.height) >> levels) > 0)
+			levels++;
+		return levels;
+	}
+
+	// Level data must lie inside the file, checked before anything is kept
+	static bool AddLevel(const std::string& file, TextureData& data, const TextureLevel& level)
+	{
+		if (level.offset > file.size() || level.size > file.size() - level.offset)
+		{
+			data.log = "truncated file";
+			return false;
+		}
+		data.levels.push_back(level);
+		return true;
+	}
+
+	static bool LoadDds(const std::string& file, TextureData& data)
+	{
+		// "DDS " magic, then a 124 byte header with the pixel format at byte 76
+		const size_t headerSize = 4 + 124;
+		if (file.size() < headerSize || file.compare(0, 4, "DDS ") != 0)
+		{
+			data.log = "not a DDS file";
+			return false;
+		}
+		// The mip count is only meaningful with DDSD_MIPMAPCOUNT set in the flags
+		const unsigned int mipMapCountFlag = 0x20000;
+		data.height = ReadU32(file, 12);
+		data.width = ReadU32(file, 16);
+		if (!IsValidSize(data))
+			return false;
+		unsigned int numLevels = (ReadU32(file, 8) & mipMapCountFlag) ? ReadU32(file, 28) : 1;
+		numLevels = std::min(std::max(numLevels, 1u), (unsigned int)MaxLevels(data));
+		unsigned int fourCC = ReadU32(file, 84);
+		size_t offset = headerSize;
+		if (memcmp(&fourCC, "DX10", 4) == 0)
+		{
+			// Extended header, only plain 2D textures are read
+			data.format = DxgiToFormat(ReadU32(file, headerSize));
+			if (ReadU32(file, headerSize + 4) != 3 || ReadU32(file, headerSize + 12) > 1)
+			{
+				data.log = "only single 2D DDS textures are supported";
+				return false;
+			}
+			offset += 20;
+		}
+		else
+			data.format = FourCCToFormat(fourCC);
+		if (data.format == 0)
+		{
+			data.log = "the DDS pixel format is not a supported BC format";
+			return false;
+		}
+
+		// Levels are stored largest first, one after the other
+		for (unsigned int i = 0; i < numLevels; i++)
+		{
+			TextureLevel level;
+			level.width = std::max(data.width >> i, 1);
+			level.height = std::max(data.height >> i, 1);
+			level.offset = offset;
+			level.size = LevelSize(data.format, level.width, level.height);
+			if (!AddLevel(file, data, level))
+				return false;
+			offset += level.size;
+		}
+		return true;
+	}
+
+	static bool LoadKtx2(const std::string& file, TextureData& data)
+	{
+		const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+		const size_t headerSize = 80;
+		if (file.size() < headerSize || memcmp(file.data(), identifier, 12) != 0)
+		{
+			data.log = "not a KTX2 file";
+			return false;
+		}
+		data.format = VkToFormat(ReadU32(file, 12));
+		data.width = ReadU32(file, 20);
+		data.height = ReadU32(file, 24);
+		unsigned int depth = ReadU32(file, 28);
+		unsigned int numLayers = ReadU32(file, 32);
+		unsigned int numFaces = ReadU32(file, 36);
+		unsigned int numLevels = ReadU32(file, 40);
+		unsigned int supercompression = ReadU32(file, 44);
+		if (data.format == 0)
+		{
+			data.log = "the KTX2 vkFormat is not a supported BC format";
+			return false;
+		}
+		if (depth > 1 || numLayers > 1 || numFaces != 1)
+		{
+			data.log = "only single 2D KTX2 textures are supported";
+			return false;
+		}
+		if (supercompression != 0)
+		{
+			data.log = "supercompressed KTX2 files (Basis, zstd) are not supported";
+			return false;
+		}
+		if (!IsValidSize(data))
+			return false;
+		// A level count of 0 asks for generated mips, only the base level is stored then
+		numLevels = std::min(std::max(numLevels, 1u), (unsigned int)MaxLevels(data));
+		if (headerSize + numLevels * 24 > file.size())
+		{
+			data.log = "truncated file";
+			return false;
+		}
+
+		// The level index follows the header, level 0 first
+		for (unsigned int i = 0; i < numLevels; i++)
+		{
+			TextureLevel level;
+			level.width = std::max(data.width >> i, 1);
+			level.height = std::max(data.height >> i, 1);
+			unsigned long long offset = ReadU64(file, headerSize + i * 24);
+			unsigned long long size = ReadU64(file, headerSize + i * 24 + 8);
+			if (size != LevelSize(data.format, level.width, level.height) || offset > file.size())
+			{
+				data.log = "unexpected KTX2 level size";
+				return false;
+			}
+			level.offset = (size_t)offset;
+			level.size = (size_t)size;
+			if (!AddLevel(file, data, level))
+				return false;
+		}
+		return true;
+	}
+
+	bool IsContainer(const std::string& path)
+	{
+		std::string ext = PathUtil::ExtensionOf(path);
+		return ext == "dds" || ext == "ktx2";
+	}
+
+	bool Load(const std::string& file, const std::string& path, TextureData& data)
+	{
+		data.isCompressed = true;
+		data.levels.clear();
+		bool isLoaded = PathUtil::ExtensionOf(path) == "dds" ? LoadDds(file, data) : LoadKtx2(file, data);
+		if (!isLoaded)
+		{
+			data.levels.clear();
+			return false;
+		}
+
+		// Only the level data is kept, packed one level after the other
+		size_t offset = 0;
+		for (auto& level : data.levels)
+		{
+			data.pixels.insert(data.pixels.end(), file.begin() + level.offset, file.begin() + level.offset + level.size);
+			level.offset = offset;
+			offset += level.size;
+		}
+		return true;
+	}
+}
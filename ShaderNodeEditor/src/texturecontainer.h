@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "imagecache.h"
+
+// Reads DDS and KTX2 containers holding block-compressed (BC1-BC7) 2D
+// textures and their mip chains, the blocks are uploaded as they are
+namespace TextureContainer
+{
+	bool IsContainer(const std::string& path);
+	// Fills the levels and format of the data from the bytes of the file at
+	// path, or its log on failure
+	bool Load(const std::string& file, const std::string& path, TextureData& data);
+}
@@ -0,0 +1,71 @@
+#include "textureformat.h"
+
+namespace TextureFormat
+{
+	static const Info s_Formats[] = {
+		{ "RGBA8", GL_RGBA8, "rgba8", GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+		{ "RG8", GL_RG8, "rg8", GL_RG, GL_UNSIGNED_BYTE, 2 },
+		{ "R8", GL_R8, "r8", GL_RED, GL_UNSIGNED_BYTE, 1 },
+		{ "RGBA16F", GL_RGBA16F, "rgba16f", GL_RGBA, GL_FLOAT, 8 },
+		{ "RG16F", GL_RG16F, "rg16f", GL_RG, GL_FLOAT, 4 },
+		{ "R16F", GL_R16F, "r16f", GL_RED, GL_FLOAT, 2 },
+		{ "R11F_G11F_B10F", GL_R11F_G11F_B10F, "r11f_g11f_b10f", GL_RGB, GL_FLOAT, 4 },
+		{ "RGBA32F", GL_RGBA32F, "rgba32f", GL_RGBA, GL_FLOAT, 16 },
+		{ "RG32F", GL_RG32F, "rg32f", GL_RG, GL_FLOAT, 8 },
+		{ "R32F", GL_R32F, "r32f", GL_RED, GL_FLOAT, 4 },
+		{ "RGBA32UI", GL_RGBA32UI, "rgba32ui", GL_RGBA_INTEGER, GL_UNSIGNED_INT, 16 },
+		{ "R32UI", GL_R32UI, "r32ui", GL_RED_INTEGER, GL_UNSIGNED_INT, 4 },
+		{ "RGBA32I", GL_RGBA32I, "rgba32i", GL_RGBA_INTEGER, GL_INT, 16 },
+		{ "R32I", GL_R32I, "r32i", GL_RED_INTEGER, GL_INT, 4 }
+	};
+
+	int Count()
+	{
+		return sizeof(s_Formats) / sizeof(s_Formats[0]);
+	}
+
+	const Info& Get(int ix)
+	{
+		return s_Formats[ix];
+	}
+
+	int IndexOf(GLenum internalFormat)
+	{
+		for (int i = 0; i < Count(); i++)
+		{
+			if (s_Formats[i].internalFormat == internalFormat)
+				return i;
+		}
+		return 0;
+	}
+
+	GLenum FromQualifier(const std::string& qualifier)
+	{
+		for (int i = 0; i < Count(); i++)
+		{
+			if (qualifier == s_Formats[i].qualifier)
+				return s_Formats[i].internalFormat;
+		}
+		return 0;
+	}
+
+	bool IsInteger(GLenum internalFormat)
+	{
+		const Info& info = Get(IndexOf(internalFormat));
+		return info.internalFormat == internalFormat && (info.format == GL_RGBA_INTEGER || info.format == GL_RED_INTEGER);
+	}
+
+	GLenum FilterFor(GLenum internalFormat)
+	{
+		return IsInteger(internalFormat) ? GL_NEAREST : GL_LINEAR;
+	}
+
+	// The combo has no user data, the table is global
+	bool GetName(void*, int ix, const char** name)
+	{
+		if (ix < 0 || ix >= Count())
+			return false;
+		*name = s_Formats[ix].name;
+		return true;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include <GL/glew.h>
+
+// Color formats selectable for image nodes and framebuffer attachments, with
+// the GLSL image format qualifier and the pixel transfer format of each
+namespace TextureFormat
+{
+	struct Info
+	{
+		const char* name;
+		GLenum internalFormat;
+		const char* qualifier;
+		// Format and type for clears and transfers
+		GLenum format;
+		GLenum type;
+		// Bytes per texel, image units only take formats of the same size
+		int pixelSize;
+	};
+
+	int Count();
+	const Info& Get(int ix);
+	// Index of the format in the table, 0 (RGBA8) if it is not in it
+	int IndexOf(GLenum internalFormat);
+	// Format of a layout qualifier such as "rgba16f", 0 if it isn't an image format
+	GLenum FromQualifier(const std::string& qualifier);
+	// Integer formats can't be filtered and are cleared with integer values
+	bool IsInteger(GLenum internalFormat);
+	// Texture filter that works with the format, nearest for integer formats
+	GLenum FilterFor(GLenum internalFormat);
+	// Items getter for ImGui::Combo
+	bool GetName(void* data, int ix, const char** name);
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cstring>
+
+#include "textureuploader.h"
+
+#include "texture.h"
+
+TextureUploader::TextureUploader(GLsizeiptr frameBudget, GLsizeiptr queueBudget, int maxDecodes) :
+	m_Ring(GL_PIXEL_UNPACK_BUFFER),
+	m_FrameBudget(frameBudget),
+	m_QueueBudget(queueBudget),
+	m_QueuedBytes(0),
+	m_MaxDecodes(maxDecodes),
+	m_NumDecodes(0),
+	m_Placeholder(-1)
+{
+}
+
+TextureUploader::~TextureUploader()
+{
+	Destroy();
+}
+
+GLuint TextureUploader::GetPlaceholder()
+{
+	// Grey and white checkers, created on first use
+	if (m_Placeholder == -1)
+	{
+		const GLubyte pixels[16] = {
+			128, 128, 128, 255,   255, 255, 255, 255,
+			255, 255, 255, 255,   128, 128, 128, 255
+		};
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_Placeholder);
+		glTextureStorage2D(m_Placeholder, 1, GL_RGBA8, 2, 2);
+		glTextureSubImage2D(m_Placeholder, 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glTextureParameteri(m_Placeholder, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(m_Placeholder, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTextureParameteri(m_Placeholder, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(m_Placeholder, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	return m_Placeholder;
+}
+
+bool TextureUploader::IsUploading(GLuint texture)
+{
+	return std::any_of(m_Uploads.begin(), m_Uploads.end(),
+		[texture](const Upload& upload) { return upload.texture == texture; });
+}
+
+int TextureUploader::NumUploads()
+{
+	return m_Uploads.size();
+}
+
+bool TextureUploader::CanDecode()
+{
+	// A single image larger than the budget still gets through once the queue is empty
+	return m_NumDecodes < m_MaxDecodes && (m_Uploads.empty() || m_QueuedBytes < m_QueueBudget);
+}
+
+void TextureUploader::BeginDecode()
+{
+	m_NumDecodes++;
+}
+
+void TextureUploader::EndDecode()
+{
+	m_NumDecodes--;
+}
+
+void TextureUploader::Queue(GLuint texture, const std::shared_ptr<const TextureData>& data)
+{
+	Upload upload;
+	upload.texture = texture;
+	upload.data = data;
+	upload.level = 0;
+	upload.row = 0;
+	m_Uploads.push_back(upload);
+	m_QueuedBytes += data->pixels.size();
+}
+
+void TextureUploader::Cancel(GLuint texture)
+{
+	for (auto& upload : m_Uploads)
+	{
+		if (upload.texture == texture)
+			m_QueuedBytes -= upload.data->pixels.size();
+	}
+	m_Uploads.erase(std::remove_if(m_Uploads.begin(), m_Uploads.end(),
+		[texture](const Upload& upload) { return upload.texture == texture; }), m_Uploads.end());
+}
+
+void TextureUploader::Update()
+{
+	if (m_Uploads.empty())
+		return;
+
+	// A segment holds at least one row of the widest queued image
+	GLsizeiptr maxRowSize = 0;
+	for (auto& upload : m_Uploads)
+	{
+		const TextureLevel& level = upload.data->levels[0];
+		maxRowSize = std::max(maxRowSize, (GLsizeiptr)(level.size / NumRows(*upload.data, level)));
+	}
+	m_Ring.Reserve(std::max(m_FrameBudget, maxRowSize));
+
+	// Rows are tightly packed, single channel rows need not be 4-byte aligned
+	m_Ring.BeginFrame();
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Ring.GetBuffer());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	while (!m_Uploads.empty())
+	{
+		Upload& upload = m_Uploads.front();
+		const TextureData& data = *upload.data;
+		const TextureLevel& level = data.levels[upload.level];
+		int levelRows = NumRows(data, level);
+		GLsizeiptr rowSize = level.size / levelRows;
+
+		// As many rows as still fit in this frame's segment
+		GLubyte* ringData = 0;
+		int numRows = levelRows - upload.row;
+		GLintptr offset = -1;
+		while (numRows > 0)
+		{
+			offset = m_Ring.Allocate(rowSize * numRows, &ringData);
+			if (offset != -1)
+				break;
+			numRows /= 2;
+		}
+		if (offset == -1)
+			break;
+
+		memcpy(ringData, data.pixels.data() + level.offset + rowSize * upload.row, rowSize * numRows);
+		if (data.isCompressed)
+		{
+			// Rows of 4x4 blocks, the last one may be cut by the level's height
+			int y = upload.row * 4;
+			int height = std::min(numRows * 4, level.height - y);
+			glCompressedTextureSubImage2D(upload.texture, upload.level, 0, y, level.width, height,
+				data.format, (GLsizei)(rowSize * numRows), (const void*)offset);
+		}
+		else
+			glTextureSubImage2D(upload.texture, upload.level, 0, upload.row, level.width, numRows,
+				data.pixelFormat, data.pixelType, (const void*)offset);
+		upload.row += numRows;
+		if (upload.row < levelRows)
+			continue;
+		upload.row = 0;
+		upload.level++;
+		if (upload.level >= data.levels.size())
+		{
+			m_QueuedBytes -= data.pixels.size();
+			m_Uploads.pop_front();
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	m_Ring.EndFrame();
+}
+
+int TextureUploader::NumRows(const TextureData& data, const TextureLevel& level)
+{
+	return data.isCompressed ? (level.height + 3) / 4 : level.height;
+}
+
+void TextureUploader::Destroy()
+{
+	m_Uploads.clear();
+	m_QueuedBytes = 0;
+	m_Ring.Destroy();
+	if (m_Placeholder != -1)
+	{
+		glDeleteTextures(1, &m_Placeholder);
+		m_Placeholder = -1;
+	}
+}
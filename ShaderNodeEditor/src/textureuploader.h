@@ -0,0 +1,62 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+
+#include <GL/glew.h>
+
+#include "ringbuffer.h"
+
+struct TextureData;
+struct TextureLevel;
+
+// Streams decoded images into their textures through a persistently mapped
+// pixel unpack ring, a bounded number of rows per frame, so large imports
+// never stall a single frame. Compressed levels are streamed a row of blocks
+// at a time. Textures show a placeholder until they are done. Decodes are
+// throttled by the number in flight and the bytes still waiting for upload
+class TextureUploader
+{
+private:
+	struct Upload
+	{
+		GLuint texture;
+		std::shared_ptr<const TextureData> data;
+		int level;
+		// In rows of pixels, or of 4x4 blocks for compressed images
+		int row;
+	};
+
+	RingBuffer m_Ring;
+	GLsizeiptr m_FrameBudget;
+	GLsizeiptr m_QueueBudget;
+	GLsizeiptr m_QueuedBytes;
+	int m_MaxDecodes;
+	int m_NumDecodes;
+	GLuint m_Placeholder;
+	std::deque<Upload> m_Uploads;
+
+public:
+	// Bytes copied into the ring and uploaded each frame, bytes allowed to wait
+	// for upload before new decodes are held back, and decodes run at once
+	TextureUploader(GLsizeiptr frameBudget = 16 * 1024 * 1024,
+		GLsizeiptr queueBudget = 256 * 1024 * 1024, int maxDecodes = 4);
+	~TextureUploader();
+
+public:
+	GLuint GetPlaceholder();
+	bool IsUploading(GLuint texture);
+	int NumUploads();
+	bool CanDecode();
+
+public:
+	void BeginDecode();
+	void EndDecode();
+	void Queue(GLuint texture, const std::shared_ptr<const TextureData>& data);
+	void Cancel(GLuint texture);
+	void Update();
+	void Destroy();
+
+private:
+	int NumRows(const TextureData& data, const TextureLevel& level);
+};
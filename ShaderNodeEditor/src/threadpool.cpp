@@ -0,0 +1,41 @@
+#include <algorithm>
+
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int numThreads) :
+	m_IsStopping(false)
+{
+	if (numThreads <= 0)
+		numThreads = std::max(1, std::min(4, (int)std::thread::hardware_concurrency() - 1));
+	for (int i = 0; i < numThreads; i++)
+		m_Workers.emplace_back(&ThreadPool::Work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_IsStopping = true;
+	}
+	m_Condition.notify_all();
+	for (auto& worker : m_Workers)
+		worker.join();
+}
+
+void ThreadPool::Work()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return m_IsStopping || !m_Tasks.empty(); });
+			// Queued tasks are still run, their futures may be waited on
+			if (m_Tasks.empty())
+				return;
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop();
+		}
+		task();
+	}
+}
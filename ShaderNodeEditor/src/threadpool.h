@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+
+// Fixed set of worker threads for blocking work that must stay off the GL
+// thread, such as reading shader sources. Tasks must not touch GL
+class ThreadPool
+{
+private:
+	std::vector<std::thread> m_Workers;
+	std::queue<std::function<void()>> m_Tasks;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	bool m_IsStopping;
+
+public:
+	// 0 picks a count from the number of hardware threads
+	ThreadPool(int numThreads = 0);
+	~ThreadPool();
+
+public:
+	template<class T>
+	std::future<T> Submit(std::function<T()> task)
+	{
+		auto packaged = std::make_shared<std::packaged_task<T()>>(task);
+		std::future<T> result = packaged->get_future();
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Tasks.push([packaged]() { (*packaged)(); });
+		}
+		m_Condition.notify_one();
+		return result;
+	}
+
+private:
+	void Work();
+};
@@ -13,8 +13,10 @@ class UniformBlock
 private:
 	std::string m_Name;
 	std::vector<Uniform> m_Uniforms;
+	int m_Index;
 	int m_Binding;
 	int m_Size;
+	std::vector<ProgramLocation> m_Locations;
 
 public:
 	UniformBlock();
@@ -23,11 +25,16 @@ public:
 
 public:
 	void SetName(const char* name);
-	std::string GetName();
-	std::vector<Uniform> GetUniforms();
+	const std::string& GetName() const;
+	const std::vector<Uniform>& GetUniforms() const;
+	void SetIndex(int index);
+	int GetIndex() const;
 	void SetBinding(int binding);
-	int GetBinding();
-	int size();
+	int GetBinding() const;
+	void AddLocation(const ProgramLocation& location);
+	const std::vector<ProgramLocation>& GetLocations() const;
+	void SetSize(int size);
+	int size() const;
 
 public:
 	void AddUniform(Uniform& uniform);